@@ -0,0 +1,93 @@
+// micro-benchmark of keyframe lookups against the number of keyframes a ball has
+#include "world.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+struct Result
+{
+    double nsPerLookup{};
+    double checksum{};
+};
+
+// looks up the position of ball 0 at every time, with or without a cursor
+Result measure(const World& world, const std::vector<Time>& times
+    , std::optional<KeyframeCursor> cursor)
+{
+    const Ball& ball{world.getBalls()[0]};
+    double checksum{0};
+
+    const auto start{std::chrono::steady_clock::now()};
+    for (const auto& t : times)
+    {
+        checksum += ball.getPositionAtTime(t, cursor).x();
+    }
+    const std::chrono::duration<double, std::nano> elapsed
+        {std::chrono::steady_clock::now() - start};
+
+    return {elapsed.count() / static_cast<double>(times.size()), checksum};
+}
+
+int main()
+{
+    constexpr std::size_t lookups{1 << 20};
+    // roughly one keyframe per collision at a few hundred collisions per
+    // second
+    constexpr int64_t keyframeIntervalNS{3'000'000};
+
+    std::cout << "keyframes;access;lookup;ns per lookup\n";
+
+    for (std::size_t keyframes : {10uz, 100uz, 1000uz, 10000uz, 100000uz
+        , 1000000uz})
+    {
+        World world{};
+        world.newBall(1, {0, 0}, 1, {1, 0});
+        for (std::size_t i{1}; i < keyframes; i++)
+        {
+            // alternating velocities so every keyframe gives a different
+            // position
+            const double v{i % 2 == 0 ? 1.0 : -0.5};
+            const Time time{Time::makeNS(keyframeIntervalNS 
+                * static_cast<int64_t>(i))};
+            world.newKeyframe(0, {world.getBalls()[0].getPositionAtTime(time)
+                , {v, 0}, time});
+        }
+        const Time span{Time::makeNS(keyframeIntervalNS 
+            * static_cast<int64_t>(keyframes))};
+
+        // playback walks through the whole history once, like the renderer
+        // does at a constant timescale
+        std::vector<Time> sequential(lookups);
+        for (std::size_t i{0}; i < lookups; i++)
+        {
+            sequential[i] = Time::makeNS(span.getNS() 
+                * static_cast<int64_t>(i) / static_cast<int64_t>(lookups));
+        }
+
+        std::default_random_engine re{42};
+        std::uniform_int_distribution<int64_t> randomTime{0, span.getNS()};
+        std::vector<Time> random(lookups);
+        for (auto& t : random) { t = Time::makeNS(randomTime(re)); }
+
+        for (const auto& [access, times] 
+            : {std::pair{"sequential", &sequential}, {"random", &random}})
+        {
+            const auto binary{measure(world, *times, std::nullopt)};
+            const auto cursor{measure(world, *times, KeyframeCursor::Physics)};
+
+            if (binary.checksum != cursor.checksum)
+            {
+                std::cerr << "cursor lookup disagrees with binary search at "
+                    << keyframes << " keyframes\n";
+                return 1;
+            }
+
+            std::cout << keyframes << ";" << access << ";binary;" 
+                << binary.nsPerLookup << "\n";
+            std::cout << keyframes << ";" << access << ";cursor;" 
+                << cursor.nsPerLookup << "\n";
+        }
+    }
+
+    return 0;
+}
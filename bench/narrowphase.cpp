@@ -0,0 +1,101 @@
+// micro-benchmark comparing narrow phase kernels on the same candidate lists
+#include "collision.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+struct CandidateList
+{
+    double x{}, y{}, radius{};
+    std::vector<double> candidateX{};
+    std::vector<double> candidateY{};
+    std::vector<double> candidateRadius{};
+};
+
+std::string kernelName(Collision::Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Collision::Kernel::Scalar: return "scalar";
+    case Collision::Kernel::SSE2:   return "sse2";
+    case Collision::Kernel::AVX2:   return "avx2";
+    }
+    return "unknown";
+}
+
+// candidates are scattered around the ball within a few radii, roughly what
+// neighbouring grid cells look like in a dense scene
+std::vector<CandidateList> makeLists(std::size_t lists, std::size_t length)
+{
+    std::default_random_engine re{42};
+    std::uniform_real_distribution<double> radius{0.05, 0.3};
+    std::uniform_real_distribution<double> offset{-1, 1};
+
+    std::vector<CandidateList> r(lists);
+    for (auto& l : r)
+    {
+        l.radius = radius(re);
+        for (std::size_t i{0}; i < length; i++)
+        {
+            l.candidateX.push_back(l.x + offset(re));
+            l.candidateY.push_back(l.y + offset(re));
+            l.candidateRadius.push_back(radius(re));
+        }
+    }
+    return r;
+}
+
+int main()
+{
+    constexpr std::size_t totalCandidates{1 << 15};
+    constexpr std::size_t repetitions{2000};
+    // same margin physics uses when looking for touching balls
+    constexpr double touchMargin{0.0000000001};
+
+    std::cout << "length;kernel;ns per candidate;hits\n";
+
+    for (std::size_t length : {4uz, 8uz, 16uz, 32uz, 64uz, 256uz})
+    {
+        const auto lists{makeLists(totalCandidates / length, length)};
+        std::vector<std::uint32_t> hits(length);
+
+        std::size_t expectedHits{0};
+        bool first{true};
+
+        for (auto kernel : {Collision::Kernel::Scalar, Collision::Kernel::SSE2
+            , Collision::Kernel::AVX2})
+        {
+            if (!Collision::isSupported(kernel)) { continue; }
+            const auto narrowPhase{Collision::getNarrowPhase(kernel)};
+
+            std::size_t hitCount{0};
+            const auto start{std::chrono::steady_clock::now()};
+            for (std::size_t rep{0}; rep < repetitions; rep++)
+            {
+                for (const auto& l : lists)
+                {
+                    hitCount += narrowPhase(l.x, l.y, l.radius
+                        , l.candidateX.data(), l.candidateY.data()
+                        , l.candidateRadius.data(), length, touchMargin
+                        , hits.data());
+                }
+            }
+            const std::chrono::duration<double, std::nano> elapsed
+                {std::chrono::steady_clock::now() - start};
+
+            if (first) { expectedHits = hitCount; first = false; }
+            else if (hitCount != expectedHits)
+            {
+                std::cerr << kernelName(kernel) << " disagrees with scalar: "
+                    << hitCount << " hits instead of " << expectedHits << "\n";
+                return 1;
+            }
+
+            std::cout << length << ";" << kernelName(kernel) << ";" 
+                << elapsed.count() / (totalCandidates * repetitions) << ";"
+                << hitCount / repetitions << "\n";
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+// throughput benchmark of the whole engine on a few standard scenarios. every
+// run happens in its own process, so peak memory is measured per run
+#include "input_handler.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// balls are placed on a jittered square lattice, one per cell, so they can
+// never overlap and setting up a million of them stays cheap
+struct Scenario
+{
+    std::string name{};
+    double minRadius{};
+    double maxRadius{};
+    // lattice cell size relative to the largest diameter
+    double spacing{};
+    // number of lattice rows, 0 for a square box
+    std::size_t rows{};
+    double speed{};
+};
+
+const std::vector<Scenario> scenarios
+{
+    // few collisions, mostly free flight
+    {"dilute",       0.05, 0.05, 4.0,  0, 1.0},
+    // balls almost touching, collisions all the time
+    {"dense",        0.05, 0.05, 1.15, 0, 1.0},
+    // radii spanning an order of magnitude, stresses the broad phase
+    {"polydisperse", 0.02, 0.2,  1.5,  0, 1.0},
+    // a strip two balls high, most collisions are with walls
+    {"wallheavy",    0.05, 0.05, 2.0,  2, 3.0}
+};
+
+struct Options
+{
+    std::vector<std::string> scenarios{};
+    std::vector<std::size_t> ballCounts{100, 1000, 10000, 100000, 1000000};
+    // each run stops at whichever of these comes first
+    double maxSimulatedSeconds{10};
+    double maxWallSeconds{5};
+    SimulationMode mode{SimulationMode::Timestep};
+    unsigned seed{1};
+};
+
+void populate(World& world, const Scenario& scenario, std::size_t balls
+    , unsigned seed)
+{
+    const double cell{2 * scenario.maxRadius * scenario.spacing};
+    const std::size_t rows{scenario.rows != 0 ? scenario.rows
+        : static_cast<std::size_t>(std::ceil(std::sqrt(balls)))};
+    const std::size_t columns{(balls + rows - 1) / rows};
+
+    world.setWorldBounds(Rect{0, 0, static_cast<double>(columns) * cell
+        , static_cast<double>(rows) * cell}, {});
+    world.reserveBalls(balls);
+
+    std::mt19937 re{seed};
+    std::uniform_real_distribution<double> radius{scenario.minRadius
+        , scenario.maxRadius};
+    std::uniform_real_distribution<double> unit{-1, 1};
+    std::uniform_real_distribution<double> angle{0, 2 * PI};
+    std::normal_distribution<double> speed{scenario.speed, scenario.speed / 4};
+
+    for (std::size_t i{0}; i < balls; i++)
+    {
+        const double r{radius(re)};
+        // room the ball has to move around in its cell
+        const double slack{cell / 2 - r};
+        const Eigen::Vector2d center
+        {
+            (static_cast<double>(i % columns) + 0.5) * cell + unit(re) * slack
+            , (static_cast<double>(i / columns) + 0.5) * cell + unit(re) * slack
+        };
+        const double a{angle(re)};
+        const double v{speed(re)};
+
+        // mass grows with area, like discs of the same material
+        world.newBallUnchecked(r, center, r * r / 0.0025
+            , {v * std::cos(a), v * std::sin(a)});
+    }
+}
+
+double kineticEnergy(const World& world)
+{
+    const auto& hot{world.getHotState()};
+
+    double r{0};
+    for (std::size_t i{0}; i < hot.size(); i++)
+    {
+        r += hot.mass[i] * hot.getVelocity(i).squaredNorm() / 2;
+    }
+    return r;
+}
+
+// runs one scenario and prints one csv row
+void run(const Scenario& scenario, std::size_t balls, const Options& options)
+{
+    AppState state{AppState::simulation};
+    World world{};
+    populate(world, scenario, balls, options.seed);
+
+    Window window{state, world, world.endTime};
+    Physiker physiker{state, world, world.endTime};
+    physiker.setSimulationMode(options.mode);
+    InputHandler::init(world, window, physiker, state);
+
+    const double startEnergy{kineticEnergy(world)};
+    const Time maxTime{Time::makeS(options.maxSimulatedSeconds)};
+
+    // stepping by hand instead of loop() lets the wall clock be checked
+    // after every step. the end time still stops events from overshooting
+    physiker.setEndTime(maxTime);
+    const auto start{std::chrono::steady_clock::now()};
+    std::chrono::duration<double> wall{};
+    while (physiker.getSimulationTime() < maxTime 
+        && wall.count() < options.maxWallSeconds)
+    {
+        physiker.step();
+        wall = std::chrono::steady_clock::now() - start;
+    }
+
+    const double simulated{physiker.getSimulationTime().getS()};
+    const auto steps{static_cast<double>(physiker.getStepCount())};
+    const auto collisions{static_cast<double>(physiker.getBallCollisionCount()
+        + physiker.getWallCollisionCount())};
+    const double drift{startEnergy > 0
+        ? (kineticEnergy(world) - startEnergy) / startEnergy : 0};
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::cout << scenario.name << ";" << balls << ";"
+        << (options.mode == SimulationMode::EventDriven ? "event" : "timestep")
+        << ";" << physiker.getStepCount() << ";"
+        << physiker.getBallCollisionCount() << ";"
+        << physiker.getWallCollisionCount() << ";"
+        << simulated << ";" << wall.count() << ";"
+        << steps / wall.count() << ";" << collisions / wall.count() << ";"
+        << simulated / wall.count() << ";" << usage.ru_maxrss << ";"
+        << drift << "\n";
+}
+
+std::optional<Options> parseOptions(int argc, char* argv[])
+{
+    Options options{};
+
+    for (int i{1}; i < argc; i++)
+    {
+        const std::string arg{argv[i]};
+        const bool hasValue{i + 1 < argc};
+        try
+        {
+        if      (arg == "--scenario" && hasValue)
+            { options.scenarios.push_back(argv[++i]); }
+        else if (arg == "--balls"    && hasValue)
+            { options.ballCounts = {std::stoul(argv[++i])}; }
+        else if (arg == "--max-balls" && hasValue)
+        {
+            const std::size_t max{std::stoul(argv[++i])};
+            std::erase_if(options.ballCounts
+                , [max](std::size_t n) { return n > max; });
+        }
+        else if (arg == "--time"     && hasValue)
+            { options.maxSimulatedSeconds = std::stod(argv[++i]); }
+        else if (arg == "--wall"     && hasValue)
+            { options.maxWallSeconds = std::stod(argv[++i]); }
+        else if (arg == "--seed"     && hasValue)
+            { options.seed = static_cast<unsigned>(std::stoul(argv[++i])); }
+        else if (arg == "--mode"     && hasValue)
+        {
+            const std::string mode{argv[++i]};
+            if      (mode == "timestep") { options.mode = SimulationMode::Timestep; }
+            else if (mode == "event")    { options.mode = SimulationMode::EventDriven; }
+            else { return std::nullopt; }
+        }
+        else { return std::nullopt; }
+        }
+        catch (const std::exception&) { return std::nullopt; }
+    }
+
+    if (options.scenarios.empty())
+    {
+        for (const auto& s : scenarios) { options.scenarios.push_back(s.name); }
+    }
+    return options;
+}
+
+int main(int argc, char* argv[])
+{
+    const auto options{parseOptions(argc, argv)};
+    if (!options)
+    {
+        std::cerr << "usage: bench [--scenario dilute|dense|polydisperse"
+            "|wallheavy]... [--balls n | --max-balls n] [--time seconds]"
+            " [--wall seconds] [--mode timestep|event] [--seed n]\n";
+        return 1;
+    }
+
+    std::cout << "scenario;balls;mode;steps;ball collisions;wall collisions"
+        ";simulated s;wall s;steps per s;collisions per s"
+        ";simulated s per wall s;peak rss kB;energy drift\n";
+
+    int failures{0};
+    for (const auto& name : options->scenarios)
+    {
+        const auto scenario{std::find_if(scenarios.begin(), scenarios.end()
+            , [&name](const Scenario& s) { return s.name == name; })};
+        if (scenario == scenarios.end())
+        {
+            std::cerr << "unknown scenario " << name << "\n";
+            return 1;
+        }
+
+        for (const auto balls : options->ballCounts)
+        {
+            std::cout.flush();
+
+            const pid_t child{fork()};
+            if (child == 0)
+            {
+                run(*scenario, balls, *options);
+                std::cout.flush();
+                _exit(0);
+            }
+
+            int status{};
+            waitpid(child, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                std::cerr << name << " with " << balls << " balls failed\n";
+                failures++;
+            }
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+// runs a scenario without a window, as fast as the cpu allows
+#include "input_handler.hpp"
+#include <chrono>
+#include <ctime>
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        Debug::err("usage: headless <scenario file> <end time in seconds>");
+        return 1;
+    }
+
+    const std::string scenario{argv[1]};
+    double endSeconds{};
+    try { endSeconds = std::stod(argv[2]); }
+    catch (const std::exception&)
+    {
+        Debug::err("end time must be a number of seconds, not " 
+            + std::string{argv[2]});
+        return 1;
+    }
+
+    AppState state = AppState::simulation;
+    World world{};
+
+    world.setWorldBounds(Rect{-5, -5, 10, 10}, {});
+
+    // the window and physics both follow the end of the simulation, so
+    // physics never waits for anything
+    Window window{state, world, world.endTime};
+    Physiker physiker{state, world, world.endTime};
+    physiker.setReadsTerminal(false);
+    physiker.setPublishesSnapshots(false);
+    physiker.setEndTime(Time::makeS(endSeconds));
+
+    InputHandler::init(world, window, physiker, state);
+    InputHandler::loadFile(scenario);
+
+    const auto wallStart{std::chrono::steady_clock::now()};
+    const std::clock_t cpuStart{std::clock()};
+
+    physiker.loop();
+
+    const std::chrono::duration<double> wall
+        {std::chrono::steady_clock::now() - wallStart};
+    const double cpu{static_cast<double>(std::clock() - cpuStart) 
+        / CLOCKS_PER_SEC};
+    const double simulated{physiker.getSimulationTime().getS()};
+
+    physiker.stopLoggingKineticEnergy();
+
+    Debug::out("balls: " + std::to_string(world.getBalls().size()));
+    Debug::out("simulated time: " + std::to_string(simulated) + " s");
+    Debug::out("wall time: " + std::to_string(wall.count()) + " s");
+    Debug::out("cpu time: " + std::to_string(cpu) + " s");
+    Debug::out("cpu s per simulated s: " 
+        + std::to_string(simulated > 0 ? cpu / simulated : 0));
+    Debug::out("simulated s per wall s: " 
+        + std::to_string(wall.count() > 0 ? simulated / wall.count() : 0));
+    Debug::out("steps: " + std::to_string(physiker.getStepCount()));
+    Debug::out("ball collisions: " 
+        + std::to_string(physiker.getBallCollisionCount()));
+    Debug::out("wall collisions: " 
+        + std::to_string(physiker.getWallCollisionCount()));
+    Debug::out("keyframes: " + std::to_string(world.getKeyframeCount()));
+    for (const auto& line : Profiler::getReport()) { Debug::out(line); }
+
+    return 0;
+}
@@ -12,5 +12,28 @@
 #include <optional>
 
 #include <Eigen/Dense>
+
+// headless builds don't link sdl at all, so the few sdl types used outside
+// of the window are defined here instead
+#ifdef SFERA_HEADLESS
+#include <cstdint>
+
+using Uint8 = std::uint8_t;
+
+struct SDL_Color
+{
+    Uint8 r;
+    Uint8 g;
+    Uint8 b;
+    Uint8 a;
+};
+
+struct SDL_Rect
+{
+    int x, y;
+    int w, h;
+};
+#else
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_ttf.h>
\ No newline at end of file
+#include <SDL2/SDL_ttf.h>
+#endif
\ No newline at end of file
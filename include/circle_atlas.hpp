@@ -0,0 +1,64 @@
+#pragma once
+
+#include "base.hpp"
+#include <atomic>
+#include <unordered_map>
+
+// texture holding pre-rasterised filled circles, so that drawing a ball is
+// copying a sprite instead of rasterising it again every frame. circles are
+// packed into shelves and stay until the atlas is cleared
+class CircleAtlas
+{
+public:
+    // circles bigger than this are cheaper to draw as geometry than to keep
+    static constexpr int maxRadius{32};
+
+    explicit CircleAtlas(SDL_Renderer* renderer);
+    ~CircleAtlas();
+
+    // false if the texture couldn't be created
+    bool isAvailable() const { return m_texture != nullptr; }
+    SDL_Texture* getTexture() const { return m_texture; }
+    static constexpr int getSize() { return m_size; }
+
+    // area of the texture with a circle of the given radius (in pixels) and
+    // colour. rasterises it first if needed. nothing if the atlas is full
+    std::optional<SDL_Rect> get(int radius, SDL_Color color);
+    // forgets all circles. the texture is kept and overwritten later
+    void clear();
+
+    // these may be used from other threads than the one drawing
+    std::size_t getHits() const { return m_hits; }
+    std::size_t getMisses() const { return m_misses; }
+    std::size_t getSpriteCount() const { return m_spriteCount; }
+    void resetStats();
+
+    CircleAtlas(const CircleAtlas& atlas) = delete;
+    CircleAtlas& operator=(const CircleAtlas& atlas) = delete;
+
+    CircleAtlas(CircleAtlas&& atlas) = delete;
+    CircleAtlas& operator=(CircleAtlas&& atlas) = delete;
+
+private:
+    static constexpr int m_size{1024};
+
+    SDL_Texture* m_texture;
+    std::unordered_map<std::uint64_t, SDL_Rect> m_sprites;
+
+    // shelf packing: sprites go left to right along the current shelf, a new
+    // shelf is started below it once it's full
+    int m_shelfX;
+    int m_shelfY;
+    int m_shelfHeight;
+
+    // pixels of the sprite being rasterised
+    std::vector<Uint8> m_pixels;
+
+    std::atomic<std::size_t> m_hits;
+    std::atomic<std::size_t> m_misses;
+    std::atomic<std::size_t> m_spriteCount;
+
+    static std::uint64_t makeKey(int radius, SDL_Color color);
+    // draws an antialiased circle into m_pixels and uploads it to area
+    void rasterise(int radius, SDL_Color color, const SDL_Rect& area);
+};
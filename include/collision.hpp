@@ -0,0 +1,47 @@
+#pragma once
+
+#include "utils.hpp"
+#include <cstdint>
+
+// collision math that doesn't depend on the world. all times are in seconds,
+// relative to the moment the given positions were measured
+namespace Collision
+{
+    // earliest time at which two balls separated by relativePosition and
+    // moving with relativeVelocity are exactly distance apart. balls that are
+    // already overlapping collide at 0 if they are approaching each other.
+    // returns nothing if the balls never touch
+    std::optional<double> ballBallTime(const Eigen::Vector2d& relativePosition
+        , const Eigen::Vector2d& relativeVelocity, double distance);
+
+    // earliest time at which the center of a ball leaves collisionBounds
+    // (the world bounds shrunk by the ball radius), and the wall it hits.
+    // balls already outside collide at 0 if they are moving further out
+    std::optional<std::pair<double, Direction>> ballWallTime
+        (const Eigen::Vector2d& position, const Eigen::Vector2d& velocity
+        , Rect collisionBounds);
+
+    // instruction sets the narrow phase can be run with
+    enum class Kernel
+    {
+        Scalar,
+        SSE2, // 2 candidates per instruction
+        AVX2  // 4 candidates per instruction
+    };
+
+    // tests one ball against count candidates, given as separate arrays of
+    // coordinates and radii. a candidate is hit if the distance between the
+    // centers is at most the sum of radii plus touchMargin times the larger
+    // radius. indices of hit candidates are written into hits, which needs
+    // room for count values. returns number of hits
+    using NarrowPhase = std::size_t (*)(double x, double y, double radius
+        , const double* candidateX, const double* candidateY
+        , const double* candidateRadius, std::size_t count, double touchMargin
+        , std::uint32_t* hits);
+
+    NarrowPhase getNarrowPhase(Kernel kernel);
+    // checks if the cpu this is running on can run the kernel
+    bool isSupported(Kernel kernel);
+    // fastest kernel the cpu supports
+    Kernel getBestKernel();
+}
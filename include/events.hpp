@@ -0,0 +1,42 @@
+#pragma once
+
+#include "world.hpp"
+
+// a predicted collision of a ball with another ball or with a wall
+struct CollisionEvent
+{
+    Time time{};
+    // indices into the ball list
+    std::size_t ballA{};
+    std::size_t ballB{}; // same as ballA for wall collisions
+    Direction wall{Direction::none}; // none for collisions between balls
+    // revisions of the balls at the time the event was predicted. if either
+    // ball got a new keyframe since, the event is no longer valid
+    std::size_t revisionA{};
+    std::size_t revisionB{};
+};
+
+// priority queue of predicted collisions, earliest first. events are never
+// removed when they become invalid, they are skipped when they reach the top
+class EventQueue
+{
+public:
+    void push(const CollisionEvent& event) { m_queue.push(event); }
+    // removes invalid events from the top of the queue, then returns the
+    // earliest valid event (if there is one)
+    std::optional<CollisionEvent> peek(const HotState& balls);
+    void pop() { m_queue.pop(); }
+
+    void clear() { m_queue = {}; }
+    std::size_t size() const { return m_queue.size(); }
+
+private:
+    struct Later
+    {
+        bool operator()(const CollisionEvent& a, const CollisionEvent& b) const
+            { return a.time > b.time; }
+    };
+
+    std::priority_queue<CollisionEvent, std::vector<CollisionEvent>, Later>
+        m_queue{};
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "world.hpp"
+#include "worker_pool.hpp"
+
+// values picked uniformly from [min, max]
+struct ValueRange
+{
+    double min{1};
+    double max{1};
+};
+
+struct GeneratorSettings
+{
+    std::size_t count{0};
+    ValueRange radius{};
+    ValueRange mass{};
+    // k_B * T, mean kinetic energy per degree of freedom. velocity components
+    // are normally distributed with a standard deviation of sqrt(kT / m), so
+    // speeds follow the (2d) maxwell-boltzmann distribution
+    double temperature{0};
+    SDL_Color color{255, 255, 255, 255};
+    TagSet tags{};
+    std::uint64_t seed{0};
+};
+
+// a ball that is already there, which generated balls must not overlap
+struct Obstacle
+{
+    Eigen::Vector2d position{0, 0};
+    double radius{0};
+};
+
+// places balls at random inside an area without any two of them overlapping
+// (poisson-disk sampling by dart throwing, looked up in a grid). the area is
+// split into tiles that are filled in parallel. there are four passes, so
+// that tiles filled at the same time never share a neighbouring cell. every
+// tile has its own random engine, so a seed always gives the same balls no
+// matter how many workers there are
+class BallGenerator
+{
+public:
+    // the pool isn't owned, it has to outlive the generator
+    explicit BallGenerator(WorkerPool& workers) : m_workers{workers} {}
+
+    // may give fewer balls than asked for if the area gets too crowded
+    std::vector<BallSpec> generate(const GeneratorSettings& settings, Rect area
+        , const std::vector<Obstacle>& obstacles = {});
+
+private:
+    // failed tries in a row after which a tile counts as full
+    static constexpr std::size_t m_maxAttempts{64};
+    // roughly how many tiles the area is split into
+    static constexpr std::size_t m_targetTiles{1024};
+
+    WorkerPool& m_workers;
+};
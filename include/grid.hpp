@@ -0,0 +1,156 @@
+#pragma once
+
+#include "world.hpp"
+
+// uniform grid used as the broad phase of collision detection. cells are at
+// least as wide as the largest ball diameter plus a margin, so two balls that
+// can touch are always in the same cell or in neighbouring cells
+class UniformGrid
+{
+public:
+    // puts every ball into its cell at the given time. if the layout of the
+    // grid is still valid (same balls, same bounds, same cell size) only the
+    // balls that changed cells are moved, otherwise the grid is rebuilt
+    void update(const HotState& balls, const std::optional<Rect>& bounds
+        , Time time, double margin);
+
+    // calls func(a, b) once for every pair of balls in the same or
+    // neighbouring cells. indices are into the ball list, a < b always
+    template <typename F>
+    void forEachCandidatePair(F&& func) const
+        { forEachCandidatePairInRows(0, m_rows, func); }
+
+    // same as forEachCandidatePair, but only for pairs found by cells in
+    // rows [firstRow, endRow). disjoint row ranges never report the same
+    // pair, so they can be searched in parallel
+    template <typename F>
+    void forEachCandidatePairInRows(int firstRow, int endRow, F&& func) const;
+
+    // calls func(ball) for every ball in cells in rows [firstRow, endRow)
+    template <typename F>
+    void forEachBallInRows(int firstRow, int endRow, F&& func) const;
+
+    // calls func(other) for every ball in the same or neighbouring cells as
+    // the given ball (other than the ball itself)
+    template <typename F>
+    void forEachNeighbour(std::size_t ball, F&& func) const;
+
+    // positions of balls at the time of the last update, by ball index
+    const std::vector<Eigen::Vector2d>& getPositions() const
+        { return m_positions; }
+
+    double getCellSize() const { return m_cellSize; }
+    int getColumns() const { return m_columns; }
+    int getRows() const { return m_rows; }
+
+private:
+    // recalculates cell size and grid extent, then sorts all balls into cells
+    void rebuild(const HotState& balls, const std::optional<Rect>& bounds
+        , double margin);
+
+    std::size_t getCell(const Eigen::Vector2d& position) const;
+    bool isInsideGrid(const Eigen::Vector2d& position) const;
+
+    void insert(std::size_t ball, std::size_t cell);
+    void remove(std::size_t ball);
+
+    // hard limit on the number of cells per ball, so that tiny balls in huge
+    // worlds don't allocate millions of empty cells
+    static constexpr std::size_t m_maxCellsPerBall{4};
+    // the margin is padded on rebuild so that slowly increasing margins
+    // (faster balls) don't cause a rebuild every update
+    static constexpr double m_marginHeadroom{1.5};
+
+    double m_cellSize{};
+    double m_margin{};
+    double m_maxRadius{};
+    int m_columns{};
+    int m_rows{};
+    Eigen::Vector2d m_origin{0, 0};
+    std::optional<Rect> m_bounds{};
+
+    // ball indices in each cell
+    std::vector<std::vector<std::size_t>> m_cells{};
+    // cell of each ball
+    std::vector<std::size_t> m_ballCell{};
+    // index of each ball inside its cell
+    std::vector<std::size_t> m_ballSlot{};
+    // ids of balls at last update, used to detect changes to the ball list
+    std::vector<int> m_ballIDs{};
+    std::vector<Eigen::Vector2d> m_positions{};
+};
+
+template <typename F>
+void UniformGrid::forEachCandidatePairInRows(int firstRow, int endRow
+    , F&& func) const
+{
+    // only half of the neighbours are checked, the other half is covered when
+    // the neighbouring cell checks this one
+    static constexpr int neighbours[4][2]{{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+    for (int y{firstRow}; y < endRow; y++)
+    {
+    for (int x{0}; x < m_columns; x++)
+    {
+        const auto& cell
+            {m_cells[static_cast<std::size_t>(y * m_columns + x)]};
+        if (cell.empty()) { continue; }
+
+        for (std::size_t i{0}; i < cell.size(); i++)
+        {
+            for (std::size_t j{i + 1}; j < cell.size(); j++)
+            {
+                func(std::min(cell[i], cell[j]), std::max(cell[i], cell[j]));
+            }
+        }
+
+        for (const auto& n : neighbours)
+        {
+            const int nx{x + n[0]};
+            const int ny{y + n[1]};
+            if (nx < 0 || nx >= m_columns || ny >= m_rows) { continue; }
+
+            const auto& other
+                {m_cells[static_cast<std::size_t>(ny * m_columns + nx)]};
+
+            for (const auto a : cell)
+            {
+                for (const auto b : other)
+                {
+                    func(std::min(a, b), std::max(a, b));
+                }
+            }
+        }
+    }}
+}
+
+template <typename F>
+void UniformGrid::forEachBallInRows(int firstRow, int endRow, F&& func) const
+{
+    const auto first{static_cast<std::size_t>(firstRow * m_columns)};
+    const auto end{static_cast<std::size_t>(endRow * m_columns)};
+
+    for (std::size_t cell{first}; cell < end; cell++)
+    {
+        for (const auto ball : m_cells[cell]) { func(ball); }
+    }
+}
+
+template <typename F>
+void UniformGrid::forEachNeighbour(std::size_t ball, F&& func) const
+{
+    const int cell{static_cast<int>(m_ballCell[ball])};
+    const int x{cell % m_columns};
+    const int y{cell / m_columns};
+
+    for (int ny{std::max(0, y - 1)}; ny <= std::min(m_rows - 1, y + 1); ny++)
+    {
+    for (int nx{std::max(0, x - 1)}; nx <= std::min(m_columns - 1, x + 1); nx++)
+    {
+        for (const auto other 
+            : m_cells[static_cast<std::size_t>(ny * m_columns + nx)])
+        {
+            if (other != ball) { func(other); }
+        }
+    }}
+}
@@ -2,7 +2,9 @@
 
 #include "window.hpp"
 #include "physics.hpp"
+#include "generator.hpp"
 #include <random>
+#include <unordered_set>
 
 class InputHandler
 {
@@ -11,11 +13,15 @@ public:
         , AppState& state);
     static void parseInput(std::string inputCommand);
     static void checkWaiting();
+    // runs every command in the file, same as the load command
+    static void loadFile(const std::string& filename);
 private:
     
     #define COMMAND std::queue<std::string>
 
-    static void runCommand(COMMAND& command);
+    // publishing can be left out when several commands run back to back and
+    // the snapshot is published once after the last one
+    static void runCommand(COMMAND& command, bool publish = true);
 
     static bool m_initalized;
     static std::string m_helpText;
@@ -43,6 +49,8 @@ private:
     static Time makeTime(std::string timeString, bool allowNegatives = false);
     static Eigen::Vector2d makeVector(std::string vectorString);
     static SDL_Color makeColor(std::string colorString);
+    // one number, or min;max
+    static ValueRange makeRange(std::string rangeString, double min = 0);
 
     static void outTime(Time time, COMMAND& command);
 
@@ -62,6 +70,8 @@ private:
         static void set(COMMAND& command);
         static void move(COMMAND& command);
         static void get(COMMAND& command);
+        // sets window time, unless the keyframes for it have been evicted
+        static void setWindowTime(Time newTime);
         class scale
         {
         public:
@@ -79,6 +89,7 @@ private:
     private:
         static void get(COMMAND& command);
         static void newball(COMMAND& command);
+        static void generate(COMMAND& command);
         static void deleteball(COMMAND& command);
         static void clear();
     };
@@ -106,6 +117,23 @@ private:
             static void move(COMMAND& command);
             static void get();
         };
+
+        class atlas
+        {
+        public:
+            static void parse(COMMAND& command);
+        private:
+            static void get();
+            static void reset();
+        };
+        class framerate
+        {
+        public:
+            static void parse(COMMAND& command);
+        private:
+            static void set(COMMAND& command);
+            static void get();
+        };
     };
 
     class bounds
@@ -148,6 +176,71 @@ private:
             static void get();
             static void set(COMMAND& command);
         };
+        class broadphase
+        {
+        public:
+            static void parse(COMMAND& command);
+        private:
+            static void get();
+            static void set(COMMAND& command);
+        };
+        class narrowphase
+        {
+        public:
+            static void parse(COMMAND& command);
+        private:
+            static void get();
+            static void set(COMMAND& command);
+        };
+        class workers
+        {
+        public:
+            static void parse(COMMAND& command);
+        private:
+            static void get();
+            static void set(COMMAND& command);
+        };
+        class retention
+        {
+        public:
+            static void parse(COMMAND& command);
+        private:
+            static void get();
+            static void set(COMMAND& command);
+        };
+        class mode
+        {
+        public:
+            static void parse(COMMAND& command);
+        private:
+            static void get();
+            static void set(COMMAND& command);
+        };
+        class search
+        {
+        public:
+            static void parse(COMMAND& command);
+        private:
+            static void get();
+            static void set(COMMAND& command);
+        };
+        // time spent in each phase of the physics loop, and counters
+        class stats
+        {
+        public:
+            static void parse(COMMAND& command);
+        private:
+            static void get();
+            static void reset();
+        };
+        class cputime
+        {
+        public:
+            static void parse(COMMAND& command);
+        private:
+            static void get();
+            static void reset();
+        };
         class logkineticenergy
         {
         public:
@@ -155,16 +248,77 @@ private:
         private:
             static void begin(COMMAND& command);
             static void end();
+            static void get();
         };
     };
 
-    class wait
+    // while a batch is open, new and deleted balls are only staged. commit
+    // applies them all at once, with a single purge and time reset. deletions
+    // are applied first, so they can only refer to balls that already exist
+    class batch
     {
     public:
-        static std::vector<std::pair<Time, COMMAND>> m_phys;
-        static std::vector<std::pair<Time, COMMAND>> m_time;
+        static void parse(COMMAND& command);
+        static bool isOpen() { return m_open; }
+        // time the staged balls are added at
+        static Time getTime() { return m_time; }
+
+        static std::vector<BallSpec> m_newBalls;
+        static std::vector<int> m_deletedIDs;
+    private:
+        static void begin();
+        static void commit(COMMAND& command);
+        static void abort();
+
+        static bool m_open;
+        // window time when the batch was begun, the balls are added then
+        static Time m_time;
+    };
+
+    // records what the threads are doing, see Tracer
+    class trace
+    {
+    public:
+        static void parse(COMMAND& command);
+    private:
+        static void begin();
+        static void end(COMMAND& command);
+    };
 
+    // commands waiting for a physics or window time, in min-heaps so that
+    // checking for due commands only has to look at the top of each
+    class wait
+    {
+    public:
         static void parse(COMMAND& command);
+        // takes all commands that are due at the given times out of the
+        // queues. physics ones come first, each in the order they are due
+        static std::vector<COMMAND> takeDue(Time physicsTime, Time windowTime);
+    private:
+        struct Waiting
+        {
+            Time time{};
+            // commands due at the same time run in the order they were queued
+            std::uint64_t order{};
+            COMMAND command{};
+        };
+        // puts the earliest command on top of the heap
+        struct Later
+        {
+            bool operator()(const Waiting& a, const Waiting& b) const
+            {
+                if (a.time == b.time) { return a.order > b.order; }
+                return a.time > b.time;
+            }
+        };
+        using Queue = std::priority_queue<Waiting, std::vector<Waiting>, Later>;
+
+        static void takeDue(Queue& queue, Time time, std::vector<COMMAND>& due);
+
+        // only used on the physics thread, which runs every command
+        static Queue m_phys;
+        static Queue m_time;
+        static std::uint64_t m_queued;
     };
 };
 
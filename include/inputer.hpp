@@ -1,26 +1,40 @@
 #pragma once
 
 #include "world.hpp"
+#include <array>
+#include <atomic>
+#include <functional>
 #include <iostream>
 
-// adapted from here: https://stackoverflow.com/questions/15074046/getting-terminal-input-with-sdl-window-open
+// reads lines from stdin on one long-lived thread and hands them over through
+// a lock-free single-producer/single-consumer ring. the reader waits while the
+// ring is full, so piped input never loses lines
 class Inputer
 {
 public:
-    static bool beginInput();
-    static bool hasInput() { return m_state == State::HasInput; }
-    static std::string getInput();
-
-    enum class State
+    // starts the reader thread, if it isn't running yet. onInput is called
+    // on the reader thread after every line
+    static void start(std::function<void()> onInput = {});
+    // whether a line is waiting. only the consuming thread may call this
+    static bool hasInput()
     {
-        Sleeping,
-        Reading,
-        HasInput
-    };
+        return m_head.load(std::memory_order_acquire) != m_tail;
+    }
+    // takes the oldest waiting line, check hasInput first
+    static std::string getInput();
 
 private:
     static void readInput();
 
-    static State m_state;
-    static std::string m_inputString;
-};
\ No newline at end of file
+    // lines the ring holds, a power of two
+    static constexpr std::size_t m_capacity{1 << 10};
+
+    static std::array<std::string, m_capacity> m_lines;
+    // lines ever read and ever taken. only the consumer touches m_tail, the
+    // reader watches m_taken to see when there is room again
+    static std::atomic<std::size_t> m_head;
+    static std::atomic<std::size_t> m_taken;
+    static std::size_t m_tail;
+    static std::atomic<bool> m_started;
+    static std::function<void()> m_onInput;
+};
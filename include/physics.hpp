@@ -1,21 +1,33 @@
 #pragma once
 
 #include "inputer.hpp"
+#include "grid.hpp"
+#include "collision.hpp"
+#include "events.hpp"
+#include "worker_pool.hpp"
+#include "sample_logger.hpp"
+#include "profiler.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
 #include <fstream>
+#include <mutex>
 
 /* collision object колобжок)))
 #define COLLOBJ std::variant<Direction, std::reference_wrapper<Ball>>
 #define COLLPAIR std::pair<COLLOBJ, COLLOBJ>*/
 
+// balls are referred to by their index in the ball list (and hot state), so
+// that collision handling only needs to touch the hot state
 class BoundBallPair
 {
 public:
-    BoundBallPair(Ball& ball, Direction direction)
+    BoundBallPair(std::size_t ball, Direction direction)
         : m_ball{ball}
         , m_dir{direction}
     {}
 
-    Ball& getBall() const { return m_ball; }
+    std::size_t getBall() const { return m_ball; }
     Direction getDir() const { return m_dir; }
 
     /*BoundBallPair(const BoundBallPair& b) = default;
@@ -23,26 +35,27 @@ public:
     BoundBallPair(const BoundBallPair&& b) = default;*/
 
 private:
-    std::reference_wrapper<Ball> m_ball;
+    std::size_t m_ball;
     Direction m_dir;
 };
 
 class BallPair
 {
 public:
-    // REALLY FUCKING IMPORTANT!!! id of first ball is ALWAYS lower than of second
-    BallPair(Ball& ballA, Ball& ballB)
-        : m_first{ballA.getID() < ballB.getID() ? ballA : ballB}
-        , m_second{ballA.getID() < ballB.getID() ? ballB : ballA}
+    // REALLY FUCKING IMPORTANT!!! index of first ball is ALWAYS lower than of
+    // second
+    BallPair(std::size_t ballA, std::size_t ballB)
+        : m_first{std::min(ballA, ballB)}
+        , m_second{std::max(ballA, ballB)}
     {}
 
-    Ball& getFirst() const { return m_first; }
-    Ball& getSecond() const { return m_second; }
+    std::size_t getFirst() const { return m_first; }
+    std::size_t getSecond() const { return m_second; }
 
     friend struct std::hash<BallPair>;
 private:
-    std::reference_wrapper<Ball> m_first;
-    std::reference_wrapper<Ball> m_second;
+    std::size_t m_first;
+    std::size_t m_second;
 };
 bool operator== (const BallPair& a, const BallPair& b);
 bool operator!= (const BallPair& a, const BallPair& b);
@@ -54,8 +67,8 @@ struct std::hash<BallPair>
     {
         // zero fucking clue what this does, idk shit about bitshifting
         // stolen: https://stackoverflow.com/questions/17016175/c-unordered-map-using-a-custom-class-type-as-the-key
-        return ((hash<int>()(bp.m_first.get().getID())
-             ^ (hash<int>()(bp.m_second.get().getID()) << 1)) >> 1);
+        return ((hash<std::size_t>()(bp.m_first)
+             ^ (hash<std::size_t>()(bp.m_second) << 1)) >> 1);
     }
 };
 
@@ -73,6 +86,27 @@ private:
     std::vector<BallPair> m_vect;
 };
 
+// algorithm used to find pairs of balls that might be colliding
+enum class BroadPhase
+{
+    BruteForce, // check every ball against every other ball
+    Grid        // only check balls in neighbouring cells of a uniform grid
+};
+
+// method used to find the time of the first collision within a timestep
+enum class CollisionSearch
+{
+    Bisection, // halve the timestep until the collision is found
+    Analytic   // solve for the exact time of impact of every pair
+};
+
+// how the simulation advances in time
+enum class SimulationMode
+{
+    Timestep,   // fixed timesteps, collisions are searched for in every step
+    EventDriven // jump straight from one predicted collision to the next
+};
+
 // class handling physics
 class Physiker
 {
@@ -97,18 +131,77 @@ public:
         { m_maxCollisionIterations = iterations; }
     int getMaxCollisionIterations() { return m_maxCollisionIterations; }
 
+    void setBroadPhase(BroadPhase broadPhase) { m_broadPhase = broadPhase; }
+    BroadPhase getBroadPhase() { return m_broadPhase; }
+
+    void setSimulationMode(SimulationMode mode) 
+    {
+        m_mode = mode;
+        m_eventsOutdated = true;
+    }
+    SimulationMode getSimulationMode() { return m_mode; }
+
+    // kernel used to test candidate pairs. falls back to scalar if the cpu
+    // doesn't support it
+    void setNarrowPhase(Collision::Kernel kernel);
+    Collision::Kernel getNarrowPhase() { return m_narrowPhaseKernel; }
+
+    // number of threads collision detection is split between, including the
+    // physics thread itself
+    void setWorkerCount(std::size_t workers);
+    std::size_t getWorkerCount() { return m_workers.getWorkerCount(); }
+    // only to be used on the physics thread, in between steps
+    WorkerPool& getWorkers() { return m_workers; }
+
+    void setCollisionSearch(CollisionSearch search) 
+        { m_collisionSearch = search; }
+    CollisionSearch getCollisionSearch() { return m_collisionSearch; }
+
     double getKineticEnergy(Time time, std::string_view tag = "");
 
     void beginLoggingKineticEnergy(const std::string& filename, Time interval
-        , const std::deque<std::string>& logTags);
+        , const std::deque<std::string>& logTags
+        , LogOverflow overflow = LogOverflow::Block);
     void stopLoggingKineticEnergy();
     bool isLoggingKineticEnergy() { return m_isLogging; }
+    const SampleLogger& getLogger() { return m_logger; }
     // deletes all keyframes, creates new keyframes with state of balls at 
     // purgeTime, resets simulation time to 0 
     void purgeKeyframes(Time purgeTime);
 
+    // number of times loop() advanced the simulation, and number of
+    // collisions handled so far
+    std::size_t getStepCount() { return m_stepCount; }
+    std::size_t getBallCollisionCount() { return m_ballCollisionCount; }
+    std::size_t getWallCollisionCount() { return m_wallCollisionCount; }
+    // cpu time the whole program used per simulated second, since the last
+    // reset. idle time counts too, it's what the simulation costs the host
+    double getCPUTimePerSimulatedSecond();
+    double getCPUTime();
+    Time getSimulatedTime() { return m_simulatedTime; }
+    void resetCPUTime();
+
+    // makes loop() return once simulation time reaches endTime
+    void setEndTime(std::optional<Time> endTime) { m_endTime = endTime; }
+    // whether loop() reads commands typed into the terminal
+    void setReadsTerminal(bool reads) { m_readsTerminal = reads; }
+    // whether snapshots are made for the window. pointless without one
+    void setPublishesSnapshots(bool publishes) 
+        { m_publishesSnapshots = publishes; }
+    // publishes the state of the world at the window time for the window to
+    // draw. loop() does this on its own whenever the window time changes
+    void publishSnapshot();
+
     // begins executing physics loop. it will run while m_state == simulation.
+    // while physics is as far ahead of the window as runahead allows, it
+    // sleeps until wake() is called
     void loop();
+    // lets a sleeping loop() go on, because the window time moved or there's
+    // a command to run. can be called from any thread
+    void wake();
+    // advances the simulation once: by one timestep (or up to the first
+    // collision in it), or up to the next event. ignores runahead and input
+    void step();
     
     ~Physiker()
     {
@@ -127,14 +220,70 @@ private:
     // * radius overlaps with bounds)
     std::vector<BoundBallPair> getOutOfBoundsBalls(bool getTouching);
 
+    // runs commands that are due and commands read from the terminal
+    void handleInput();
+
     BallPairVector getCollidingBalls(bool getTouching);
+
+    // sorts balls into the broad phase at the given time. pairs further apart
+    // than their radii plus margin are not guaranteed to be reported.
+    // returns positions of the balls at that time
+    const std::vector<Eigen::Vector2d>& updateBroadPhase(Time time
+        , double margin);
+    // calls func(a, b) with indices of every pair found by the last broad
+    // phase update, a < b
+    template <typename F>
+    void forEachCandidatePair(F&& func);
+    // calls func(b) for every ball found near ball a by the last broad phase
+    // update
+    template <typename F>
+    void forEachCandidateOf(std::size_t a, F&& func);
+
+    // detection is split into tiles which the workers take turns on. with
+    // the grid a tile is a band of cell rows, with brute force it's a range
+    // of ball indices. has to be called after the broad phase update
+    std::size_t getTileCount();
+    // calls func(a) for every ball in the tile
+    template <typename F>
+    void forEachBallInTile(std::size_t tile, std::size_t tileCount, F&& func);
+    // calls func(a, b) for every pair found by the tile. every pair is
+    // found by exactly one tile
+    template <typename F>
+    void forEachCandidatePairInTile(std::size_t tile, std::size_t tileCount
+        , F&& func);
+    // range [first, end) of the tile when count things are split into
+    // tileCount tiles
+    static std::pair<std::size_t, std::size_t> getTileRange(std::size_t tile
+        , std::size_t tileCount, std::size_t count);
+
     // tries to find the exact time at which the first collision within the
     // current timestep occurred
     void findCollisionTime();
+    void findCollisionTimeBisection();
+    void findCollisionTimeAnalytic();
     // makes balls bounce off walls
     void handleBoundsCollisions();
     // makes balls bounce off each other
     void handleBallCollisions();
+    // makes one ball bounce off the given wall
+    void resolveBoundsCollision(std::size_t ball, Direction dir);
+    // makes two balls bounce off each other. returns false (and does nothing)
+    // if the balls are already moving apart
+    bool resolveBallCollision(std::size_t ballA, std::size_t ballB);
+
+    // advances to the next predicted collision and handles it. stops early
+    // at the prediction horizon, the runahead limit or the next log time
+    void stepEvents();
+    // throws away all predicted events and predicts them again for every
+    // ball, starting from the current simulation time
+    void predictAllEvents();
+    // predicts the next collisions of one ball with walls and nearby balls.
+    // collisions with the ball skip are not predicted
+    void predictEvents(std::size_t ball
+        , std::optional<std::size_t> skip = std::nullopt);
+    // returns whether an event was queued
+    bool predictBallEvent(std::size_t ballA, std::size_t ballB);
+    void predictWallEvent(std::size_t ball);
 
     // interval at which physics calculations will be performed
     Time m_timestep;
@@ -147,16 +296,83 @@ private:
     Time m_simulationTime;
     // how far ahead of the graphics time physics time is allowed to run
     Time m_runahead;
+    std::optional<Time> m_endTime;
+    bool m_readsTerminal;
+    bool m_publishesSnapshots;
+    // window time the last snapshot was made for
+    Time m_snapshotTime;
+    // the window extrapolates between snapshots, so there is no point in
+    // making them much more often than it can show them
+    static constexpr std::chrono::milliseconds m_snapshotInterval{8};
+    std::chrono::steady_clock::time_point m_nextSnapshot;
+    // loop() waits on this instead of spinning while it's too far ahead
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeSignal;
+    bool m_woken;
+    // process cpu time at the last reset, and time simulated since then.
+    // rewinds don't take simulated time back, the work was done anyway
+    std::clock_t m_cpuStart;
+    Time m_simulatedTime;
+    std::size_t m_stepCount;
+    std::size_t m_ballCollisionCount;
+    std::size_t m_wallCollisionCount;
+
+    BroadPhase m_broadPhase;
+    UniformGrid m_grid;
+    // positions used by the brute force broad phase
+    std::vector<Eigen::Vector2d> m_positions;
+
+    Collision::Kernel m_narrowPhaseKernel;
+    Collision::NarrowPhase m_narrowPhase;
+    CollisionSearch m_collisionSearch;
+
+    // parallel detection stuff
+    WorkerPool m_workers;
+    // every worker gets its own buffers so they never have to be locked
+    struct WorkerBuffers
+    {
+        // candidates of one ball, gathered so the narrow phase can stream them
+        std::vector<double> candidateX{};
+        std::vector<double> candidateY{};
+        std::vector<double> candidateRadius{};
+        std::vector<std::size_t> candidateIndex{};
+        std::vector<std::uint32_t> hits{};
+    };
+    std::vector<WorkerBuffers> m_workerBuffers;
+    // results of each tile, merged in tile order once all workers are done
+    std::vector<std::vector<BallPair>> m_tilePairs;
+    std::vector<std::vector<BoundBallPair>> m_tileBoundPairs;
+    std::vector<std::optional<double>> m_tileEarliest;
+    // tiles per worker. more tiles than workers lets idle workers steal some
+    // of the work when tiles take different amounts of time
+    static constexpr std::size_t m_tilesPerWorker{4};
+
+    // event driven simulation stuff
+    SimulationMode m_mode;
+    EventQueue m_events;
+    // set when the world changed in a way that makes predictions wrong
+    bool m_eventsOutdated;
+    // events are only predicted up to this time, after which all of them are
+    // predicted again
+    Time m_eventHorizon;
+    // highest speed of any ball when events were predicted. the broad phase
+    // is only valid while no ball is faster than this
+    double m_eventMaxSpeed;
+    std::size_t m_eventBallCount;
+
+    // keyframe retention is checked every m_retentionInterval of simulation
+    static constexpr int64_t m_retentionIntervalMS{100};
+    Time m_nextRetentionCheck;
 
-    // logging stuff
-    std::ofstream m_logStream;
+    // logging stuff. samples are only collected here, the logger formats
+    // and writes them on its own thread
+    SampleLogger m_logger;
     bool m_isLogging;
     Time m_nextLogTime;
     Time m_logInterval;
     std::deque<std::string> m_logTags;
-    char m_sep;
+    std::vector<double> m_logSample;
     void logKineticEnergy();
-    void writeValToLog(std::string_view value);
     // stolen: https://stackoverflow.com/questions/12774207/fastest-way-to-check-if-a-file-exists-using-standard-c-c11-14-17-c
     bool fileExists(const std::string& name);
 
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "base.hpp"
+#include "trace.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+// parts of the physics loop that are timed. they nest: step contains
+// collision time, which contains broad phase, and so on
+enum class Phase
+{
+    Step,
+    BroadPhase,
+    CollisionTime,
+    BoundsCollisions,
+    BallCollisions,
+    EventPrediction,
+    Retention,
+    Logging,
+    Input,
+    Snapshot,
+    count
+};
+
+enum class Counter
+{
+    BisectionIterations,
+    PairsTested,
+    PairsHit,
+    count
+};
+
+struct PhaseStats
+{
+    std::uint64_t calls{};
+    std::chrono::nanoseconds total{};
+    std::chrono::nanoseconds max{};
+};
+
+struct ProfileStats
+{
+    std::array<PhaseStats, static_cast<std::size_t>(Phase::count)> phases{};
+    std::array<std::uint64_t, static_cast<std::size_t>(Counter::count)>
+        counters{};
+
+    const PhaseStats& operator[](Phase phase) const
+        { return phases[static_cast<std::size_t>(phase)]; }
+    std::uint64_t operator[](Counter counter) const
+        { return counters[static_cast<std::size_t>(counter)]; }
+};
+
+// collects phase times and counters. every thread adds to its own block, so
+// recording never waits for a lock or fights over a cache line
+class Profiler
+{
+public:
+    static void addTime(Phase phase, std::chrono::nanoseconds time);
+    static void add(Counter counter, std::uint64_t amount = 1);
+
+    // sums over all threads since the last reset
+    static ProfileStats get();
+    static void reset();
+    // one line per phase and counter, for printing
+    static std::vector<std::string> getReport();
+
+    static std::string_view getName(Phase phase);
+    static std::string_view getName(Counter counter);
+
+private:
+    // written only by its thread, atomics so that get() can read it anytime
+    struct ThreadStats
+    {
+        std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(
+            Phase::count)> calls{};
+        std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(
+            Phase::count)> totalNS{};
+        std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(
+            Phase::count)> maxNS{};
+        std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(
+            Counter::count)> counters{};
+        // reset() only bumps the global epoch. threads clear their own block
+        // when they see it changed, so nobody writes to another thread's block
+        std::atomic<std::uint64_t> epoch{};
+    };
+
+    static ThreadStats& getThreadStats();
+    static void bump(std::atomic<std::uint64_t>& value, std::uint64_t amount)
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount
+            , std::memory_order_relaxed);
+    }
+
+    // blocks of threads that have ended stay, their counts still matter
+    static std::mutex m_mutex;
+    static std::vector<std::unique_ptr<ThreadStats>> m_threads;
+    static std::atomic<std::uint64_t> m_epoch;
+};
+
+// adds the time between its construction and destruction to a phase, and
+// records it as a span while tracing
+class ProfileScope
+{
+public:
+    explicit ProfileScope(Phase phase)
+        : m_phase{phase}
+        , m_start{std::chrono::steady_clock::now()}
+    {}
+    ~ProfileScope()
+    {
+        const auto end{std::chrono::steady_clock::now()};
+        Profiler::addTime(m_phase, end - m_start);
+        if (Tracer::isEnabled())
+        {
+            Tracer::record(Profiler::getName(m_phase), m_start, end);
+        }
+    }
+
+    ProfileScope(const ProfileScope& scope) = delete;
+    ProfileScope& operator=(const ProfileScope& scope) = delete;
+
+    ProfileScope(ProfileScope&& scope) = delete;
+    ProfileScope& operator=(ProfileScope&& scope) = delete;
+
+private:
+    Phase m_phase;
+    std::chrono::steady_clock::time_point m_start;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "base.hpp"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <span>
+
+// what happens to samples pushed while the writer is too far behind
+enum class LogOverflow
+{
+    Block, // wait until there is room, never lose a sample
+    Drop   // throw the sample away and count it
+};
+
+// writes rows of numbers to a csv file on its own thread. samples go through
+// a lock-free ring buffer, so pushing one never waits on the disk, and the
+// writer formats and writes them in big blocks
+class SampleLogger
+{
+public:
+    SampleLogger();
+    ~SampleLogger() { close(); }
+
+    // opens the file, writes the column names and starts the writer. every
+    // sample must then have one value per column
+    bool open(const std::string& filename, const std::vector<std::string>& columns
+        , LogOverflow overflow);
+    // writes out everything still queued and closes the file
+    void close();
+    bool isOpen() const { return m_thread.joinable(); }
+
+    // queues a sample. only one thread may push
+    void push(std::span<const double> sample);
+
+    // samples the writer has taken and samples thrown away since open()
+    std::size_t getWrittenCount() const { return m_written; }
+    std::size_t getDroppedCount() const { return m_dropped; }
+    LogOverflow getOverflow() const { return m_overflow; }
+
+    SampleLogger(const SampleLogger& logger) = delete;
+    SampleLogger& operator=(const SampleLogger& logger) = delete;
+
+    SampleLogger(SampleLogger&& logger) = delete;
+    SampleLogger& operator=(SampleLogger&& logger) = delete;
+
+private:
+    // samples the ring buffer holds, a power of two
+    static constexpr std::size_t m_capacity{1 << 12};
+    // formatted text is written once there is this much of it
+    static constexpr std::size_t m_blockSize{1 << 16};
+    // how long the writer sleeps when there is nothing to write
+    static constexpr std::chrono::milliseconds m_idleSleep{2};
+    // text smaller than a block is still written once it is this old
+    static constexpr std::chrono::milliseconds m_flushInterval{1000};
+    static constexpr char m_sep{';'};
+
+    std::ofstream m_stream;
+    std::thread m_thread;
+    LogOverflow m_overflow;
+
+    // m_capacity rows of m_width values each
+    std::vector<double> m_ring;
+    std::size_t m_width;
+    // samples ever pushed and ever taken by the writer. their difference is
+    // how full the ring is
+    std::atomic<std::size_t> m_head;
+    std::atomic<std::size_t> m_tail;
+    std::atomic<bool> m_stopping;
+
+    std::atomic<std::size_t> m_written;
+    std::atomic<std::size_t> m_dropped;
+
+    void writerLoop();
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "utils.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// everything the window needs to draw the world around one point in time.
+// every ball is stored as the straight line it moves along around that time,
+// so positions a bit before or after it can be drawn without keyframes
+struct WorldSnapshot
+{
+    // time physics made the snapshot for
+    Time time{};
+    // set if the keyframes for time had been evicted, in which case the
+    // snapshot was made for this time instead
+    std::optional<Time> inaccessibleBefore{};
+
+    // ball i moves from the start position with its velocity between
+    // segmentStart and segmentEnd
+    std::vector<double> positionX{};
+    std::vector<double> positionY{};
+    std::vector<double> velocityX{};
+    std::vector<double> velocityY{};
+    std::vector<Time> segmentStart{};
+    std::vector<Time> segmentEnd{};
+
+    std::vector<double> radius{};
+    std::vector<SDL_Color> color{};
+
+    std::optional<Rect> bounds{};
+
+    std::size_t size() const { return radius.size(); }
+    void resize(std::size_t count);
+
+    // position of ball i at time. times outside of the segment are clamped
+    // to it, so the ball stops at its next collision until a newer snapshot
+    // comes in
+    Eigen::Vector2d getPosition(std::size_t i, Time time) const;
+};
+
+// hands snapshots from physics to the window without locks. three buffers
+// take turns: physics fills one, the window draws another and the third holds
+// the latest finished snapshot. publishing and reading swap a buffer with the
+// third one, so neither side ever waits and buffers get reused, not allocated
+class SnapshotChannel
+{
+public:
+    // buffer to fill with the next snapshot. only the physics thread may use
+    // it, and only until publish()
+    WorldSnapshot& beginWrite() { return m_buffers[m_writeIndex]; }
+    // makes the buffer from beginWrite() the latest snapshot
+    void publish();
+    // latest published snapshot. only the window thread may use it, it stays
+    // unchanged until the next read()
+    const WorldSnapshot& read();
+
+private:
+    std::array<WorldSnapshot, 3> m_buffers{};
+
+    // index of the buffer in between, with m_freshFlag set if it holds a
+    // snapshot the reader hasn't seen yet
+    std::atomic<std::uint8_t> m_middle{1};
+    static constexpr std::uint8_t m_freshFlag{4};
+    static constexpr std::uint8_t m_indexMask{3};
+
+    // owned by the writer and the reader respectively
+    std::uint8_t m_writeIndex{0};
+    std::uint8_t m_readIndex{2};
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "base.hpp"
+#include <bit>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+// small number standing in for a tag name
+using TagID = std::uint32_t;
+
+// gives every tag name ever used its own id, so that tags can be stored and
+// compared as numbers. names are never forgotten and ids never reused
+class TagInterner
+{
+public:
+    // id of the name, giving it a new one if it has none yet
+    static TagID intern(std::string_view name);
+    // id of the name, nothing if it has never been interned
+    static std::optional<TagID> find(std::string_view name);
+    static const std::string& getName(TagID id);
+
+private:
+    static std::mutex m_mutex;
+    // a deque so that names never move and the views in m_ids stay valid
+    static std::deque<std::string> m_names;
+    static std::unordered_map<std::string_view, TagID> m_ids;
+};
+
+// tags of one ball as a bitset, bit i is set if it has the tag with id i
+class TagSet
+{
+public:
+    bool contains(TagID id) const
+    {
+        if (id < 64) { return (m_bits >> id & 1) != 0; }
+
+        const std::size_t word{id / 64 - 1};
+        return word < m_more.size() && (m_more[word] >> (id % 64) & 1) != 0;
+    }
+    void insert(TagID id);
+    bool empty() const;
+
+    // calls func(id) for every tag in the set, lowest id first
+    template <typename F>
+    void forEach(F&& func) const
+    {
+        forEachInWord(m_bits, 0, func);
+        for (std::size_t w{0}; w < m_more.size(); w++)
+        {
+            forEachInWord(m_more[w], static_cast<TagID>((w + 1) * 64), func);
+        }
+    }
+
+private:
+    // the first 64 tags fit without allocating anything
+    std::uint64_t m_bits{0};
+    std::vector<std::uint64_t> m_more{};
+
+    template <typename F>
+    static void forEachInWord(std::uint64_t word, TagID first, F& func)
+    {
+        while (word != 0)
+        {
+            func(first + static_cast<TagID>(std::countr_zero(word)));
+            word &= word - 1;
+        }
+    }
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "base.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+// records begin/end spans of what every thread is doing, and writes them as
+// chrome trace event json (chrome://tracing or ui.perfetto.dev). while it is
+// off a span costs one relaxed atomic load
+class Tracer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static bool isEnabled()
+        { return m_enabled.load(std::memory_order_relaxed); }
+    // throws away everything recorded so far and starts recording
+    static void begin();
+    // stops recording
+    static void end();
+    // writes everything recorded since begin(). returns the number of spans
+    // written, nothing if the file couldn't be opened
+    static std::optional<std::size_t> write(const std::string& filename);
+    // spans that didn't fit into their thread's buffer since begin()
+    static std::size_t getDroppedCount();
+
+    // name the calling thread shows up with
+    static void setThreadName(std::string name);
+    // adds a span to the calling thread's buffer. name has to outlive the
+    // tracer, detail is copied
+    static void record(std::string_view name, Clock::time_point start
+        , Clock::time_point end, std::string_view detail = {});
+
+private:
+    struct Span
+    {
+        std::string_view name{};
+        std::int64_t startNS{};
+        std::int64_t endNS{};
+        std::string detail{};
+    };
+    // written only by its thread. count is published with release, so the
+    // spans below it can be read by write() at any time
+    struct ThreadBuffer
+    {
+        std::string name{};
+        std::vector<Span> spans{};
+        std::atomic<std::size_t> count{0};
+        std::atomic<std::size_t> dropped{0};
+        // begin() only bumps the global epoch, threads empty their own buffer
+        // when they see it changed
+        std::atomic<std::uint64_t> epoch{0};
+    };
+
+    static ThreadBuffer& getThreadBuffer();
+    static std::int64_t sinceOrigin(Clock::time_point time)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            time - m_origin).count();
+    }
+
+    // spans each thread can hold between begin() and write()
+    static constexpr std::size_t m_capacity{1 << 16};
+
+    static std::atomic<bool> m_enabled;
+    static std::atomic<std::uint64_t> m_epoch;
+    static const Clock::time_point m_origin;
+    // buffers of threads that have ended stay, their spans still matter
+    static std::mutex m_mutex;
+    static std::vector<std::unique_ptr<ThreadBuffer>> m_threads;
+};
+
+// records the time between its construction and destruction as a span, if
+// tracing was on when it was constructed
+class TraceSpan
+{
+public:
+    explicit TraceSpan(std::string_view name)
+        : m_name{name}
+        , m_start{Tracer::isEnabled() ? Tracer::Clock::now()
+            : Tracer::Clock::time_point{}}
+    {}
+    ~TraceSpan()
+    {
+        if (m_start != Tracer::Clock::time_point{})
+        {
+            Tracer::record(m_name, m_start, Tracer::Clock::now());
+        }
+    }
+
+    TraceSpan(const TraceSpan& span) = delete;
+    TraceSpan& operator=(const TraceSpan& span) = delete;
+
+    TraceSpan(TraceSpan&& span) = delete;
+    TraceSpan& operator=(TraceSpan&& span) = delete;
+
+private:
+    std::string_view m_name;
+    Tracer::Clock::time_point m_start;
+};
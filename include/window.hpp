@@ -1,6 +1,73 @@
 #pragma once
 
 #include "world.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+// how well the circle sprite atlas is doing, for tuning
+struct AtlasStats
+{
+    std::size_t hits{};
+    std::size_t misses{};
+    std::size_t sprites{};
+};
+
+#ifdef SFERA_HEADLESS
+// stands in for the window when running without graphics. it keeps the view
+// settings so that scenario files using them still load, and its time always
+// follows the simulation
+class Window
+{
+public:
+    Window(const AppState&, const World&, Time& currentTime)
+        : m_displayScale{100}
+        , m_viewOffset{0, 0}
+        , m_timescale{1}
+        , m_currentTime{currentTime}
+    {}
+
+    // there is nothing to go back to, time is wherever the simulation is
+    void setTime(Time) {}
+    Time getTime() const { return m_currentTime; }
+
+    void setTimescale(double newScale) { m_timescale = newScale; }
+    double getTimescale() const { return m_timescale; }
+
+    void setZoom(double zoom) { m_displayScale = zoom * 100; }
+    double getZoom() const { return m_displayScale / 100; }
+
+    void setViewOffset(Eigen::Vector2d offset) { m_viewOffset = offset; }
+    Eigen::Vector2d getViewOffset() const { return m_viewOffset; }
+
+    void recenterView() {}
+
+    // nothing is drawn, so there's no atlas either
+    AtlasStats getAtlasStats() const { return {}; }
+    void resetAtlasStats() {}
+
+    // there are no frames to limit
+    void setFrameLimit(double fps) { m_frameLimit = fps; }
+    double getFrameLimit() const { return m_frameLimit; }
+    void setOnFrame(std::function<void()>) {}
+
+    Window(const Window& window) = delete;
+    Window& operator=(const Window& window) = delete;
+
+    Window(Window&& window) = delete;
+    Window& operator=(Window&& window) = delete;
+
+private:
+    double m_displayScale;
+    Eigen::Vector2d m_viewOffset;
+    double m_timescale;
+    double m_frameLimit{0};
+
+    Time& m_currentTime;
+};
+#else
+
+#include "circle_atlas.hpp"
 
 // stolen: https://gamedev.stackexchange.com/questions/110825/how-to-calculate-delta-time-with-sdl
 struct Clock
@@ -39,12 +106,30 @@ public:
     void setTimescale(double newScale) { m_timescale = newScale; }
     double getTimescale() const { return m_timescale; }
 
-    void setZoom(double zoom) { m_displayScale = zoom * 100; }
+    // circles cached at the old zoom are useless at the new one, so the
+    // atlas gets cleared by the next redraw
+    void setZoom(double zoom) 
+    { 
+        m_displayScale = zoom * 100;
+        m_atlasOutdated = true;
+    }
     double getZoom() const { return m_displayScale / 100; }
 
     void setViewOffset(Eigen::Vector2d offset) { m_viewOffset = offset; }
     Eigen::Vector2d getViewOffset() const { return m_viewOffset; }
 
+    AtlasStats getAtlasStats() const;
+    void resetAtlasStats();
+
+    // frames per second loop() draws at most, 0 for as many as it can
+    void setFrameLimit(double fps)
+        { m_frameLimit.store(fps, std::memory_order_relaxed); }
+    double getFrameLimit() const
+        { return m_frameLimit.load(std::memory_order_relaxed); }
+    // called after every frame, once the window time has moved on
+    void setOnFrame(std::function<void()> onFrame) 
+        { m_onFrame = std::move(onFrame); }
+
     void recenterView()
     {
         int w{};
@@ -74,6 +159,31 @@ private:
 
     int screenDrawFilledCircle(SDL_Color color, int x, int y, int radius);
 
+    // draw in screen coordinates, batched if the renderer can draw geometry
+    void drawScreenCircle(SDL_Color color, float x, float y, float radius
+        , bool filled);
+    void drawScreenPoint(SDL_Color color, float x, float y);
+    void drawScreenFilledRect(SDL_Color color, float x, float y, float w
+        , float h);
+
+    // adds a circle to the batch, drawn with the rest of it in flushCircles()
+    void batchCircle(SDL_Color color, float x, float y, float radius
+        , bool filled);
+    void batchRect(SDL_Color color, float x, float y, float w, float h);
+    // draws a filled circle from the atlas. false if it can't be used
+    bool drawSprite(SDL_Color color, float x, float y, int radius);
+    // draws the batch with one SDL_RenderGeometry call. only one of the
+    // sprite and geometry batches is filled at a time, the other one is
+    // flushed when switching, so that things are drawn in the order they
+    // were batched
+    void flushCircles();
+    void flushSprites();
+    void flushGeometry();
+    // switches to drawing line by line after SDL_RenderGeometry failed
+    void disableGeometry();
+    // points around a circle of radius 1, cached for every segment count
+    const std::vector<SDL_FPoint>& getUnitCircle(std::size_t segments);
+
     static constexpr int m_defaultWidth{1080};
     static constexpr int m_defaultHeight{1080};
     static constexpr int m_minWidth{300};
@@ -85,6 +195,62 @@ private:
 
     TTF_Font *m_UIfontSDL;
 
+    // circles are tessellated into one vertex buffer and drawn all at once.
+    // renderers that can't draw geometry get every circle drawn line by line
+    bool m_hasGeometry;
+    std::vector<SDL_Vertex> m_circleVertices;
+    std::vector<int> m_circleIndices;
+    std::vector<std::vector<SDL_FPoint>> m_unitCircles;
+    // what is in the batch, so that it can still be drawn line by line if
+    // drawing it as geometry fails
+    enum class ShapeKind
+    {
+        FilledCircle,
+        Circle,
+        Rect
+    };
+    struct BatchedShape
+    {
+        ShapeKind kind{};
+        SDL_Color color{};
+        float x{};
+        float y{};
+        // circles only use w, as their radius
+        float w{};
+        float h{};
+    };
+    std::vector<BatchedShape> m_batchedShapes;
+
+    // small filled circles are copied from pre-rasterised sprites instead.
+    // the sprites are batched like the circles, as quads textured with the
+    // atlas
+    std::optional<CircleAtlas> m_atlas;
+    std::atomic<bool> m_atlasOutdated;
+    std::vector<SDL_Vertex> m_spriteVertices;
+    std::vector<int> m_spriteIndices;
+    // source and destination of every batched sprite, for SDL_RenderCopy
+    std::vector<std::pair<SDL_Rect, SDL_Rect>> m_batchedSprites;
+    // the batch is flushed early once it gets this big
+    static constexpr std::size_t m_maxBatchVertices{1 << 16};
+
+    // level of detail. balls off screen are skipped, balls smaller than a
+    // pixel become points and small balls crowded into one heatmap tile
+    // become one rectangle coloured by how many of them there are
+    struct VisibleBall
+    {
+        float x{}, y{}, radius{};
+        std::size_t ball{};
+        // heatmap tile the ball may be merged into, if it's small enough
+        std::optional<std::size_t> tile{};
+    };
+    std::vector<VisibleBall> m_visibleBalls;
+    std::vector<std::size_t> m_heatmapCounts;
+    static constexpr int m_heatmapTileSize{8}; // in pixels
+    // balls in a tile it takes for the tile to be drawn as heatmap
+    static constexpr std::size_t m_heatmapThreshold{24};
+    // blue at the threshold, red at 16 times it
+    static SDL_Color getHeatmapColor(std::size_t count);
+
     double m_displayScale;
     Eigen::Vector2d m_displayCenter;
     Eigen::Vector2d m_viewOffset;
@@ -92,7 +258,14 @@ private:
     Time m_time;
     Clock m_clock;
 
+    // loop() sleeps until the next frame is due instead of drawing as fast
+    // as it can. set by commands on the physics thread
+    std::atomic<double> m_frameLimit;
+    std::chrono::steady_clock::time_point m_nextFrame;
+    std::function<void()> m_onFrame;
+
     const AppState& m_state;
     const World& m_world;
     Time& m_currentTime;
-};
\ No newline at end of file
+};
+#endif
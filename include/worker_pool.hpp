@@ -0,0 +1,64 @@
+#pragma once
+
+#include "base.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// persistent threads that split a batch of tasks between them. each worker
+// has its own queue of tasks and steals from the others once it runs out
+class WorkerPool
+{
+public:
+    // function run for every task. gets the task index and the index of the
+    // worker running it, which can be used to pick per-worker buffers
+    using Job = std::function<void(std::size_t task, std::size_t worker)>;
+
+    explicit WorkerPool(std::size_t workers = 1);
+    ~WorkerPool();
+
+    // stops all threads and starts the given number of workers. the calling
+    // thread always counts as worker 0, so 1 means no extra threads
+    void setWorkerCount(std::size_t workers);
+    std::size_t getWorkerCount() const { return m_queues.size(); }
+
+    // runs job for every task in [0, taskCount) and returns once all of them
+    // are done. the calling thread works on tasks too
+    void run(std::size_t taskCount, const Job& job);
+
+    WorkerPool(const WorkerPool& pool) = delete;
+    WorkerPool& operator=(const WorkerPool& pool) = delete;
+
+    WorkerPool(WorkerPool&& pool) = delete;
+    WorkerPool& operator=(WorkerPool&& pool) = delete;
+
+private:
+    struct TaskQueue
+    {
+        std::mutex mutex{};
+        std::deque<std::size_t> tasks{};
+    };
+
+    void startThreads(std::size_t workers);
+    void stopThreads();
+    // main loop of every thread except worker 0
+    void work(std::size_t worker);
+    // runs one task from the worker's own queue, or steals one from another
+    // queue. returns false if there was nothing left to do
+    bool runOneTask(std::size_t worker);
+
+    std::vector<std::thread> m_threads;
+    std::vector<std::unique_ptr<TaskQueue>> m_queues;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const Job* m_job;
+    // increased for every batch, so sleeping workers know there's new work
+    std::size_t m_batch;
+    std::atomic<std::size_t> m_remaining;
+    bool m_stopping;
+};
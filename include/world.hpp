@@ -3,8 +3,12 @@
 #include "appinfo.hpp"
 #include "debug.hpp"
 #include "utils.hpp"
+#include "snapshot.hpp"
+#include "tags.hpp"
+#include <array>
 #include <cstdint>
 #include <ranges>
+#include <unordered_map>
 
 class Window;
 
@@ -18,28 +22,47 @@ public:
     Time keyframeTime{};
 };
 
+// users of keyframe lookups that remember where their last lookup ended up.
+// each one must only be used from one thread
+enum class KeyframeCursor
+{
+    Renderer, // building snapshots for the window, on the physics thread
+    Physics,
+    count
+};
+
 class Ball
 {
 public:
-    std::deque<std::string> tags;
-
+    const TagSet& getTags() const { return m_tags; }
     // get tags as one semicolon-separated string
     std::string getTagsAsString() const;
-    // get tags from one semicolon-separated string
-    static std::deque<std::string> getTagsFromString(std::string_view str);
+    // get tags from one semicolon-separated string, interning new ones
+    static TagSet getTagsFromString(std::string_view str);
     // always returns true with empty string as input
     bool hasTag(std::string_view tag) const;
+    bool hasTag(TagID tag) const { return m_tags.contains(tag); }
 
     bool isInBounds(Rect bounds, Time time) const;
 
+    // lookups with a cursor start searching where the last lookup with the
+    // same cursor ended, which is O(1) when time only moves a little between
+    // them. without a cursor they are a binary search
     double getRadius() const { return m_radius; }
-    const Eigen::Vector2d getPositionAtTime(Time time) const;
+    const Eigen::Vector2d getPositionAtTime(Time time
+        , std::optional<KeyframeCursor> cursor = std::nullopt) const;
     SDL_Color getColor() const { return m_color; }
-    const Keyframe& getLastKeyframeBeforeTime(Time time) const;
+    const Keyframe& getLastKeyframeBeforeTime(Time time
+        , std::optional<KeyframeCursor> cursor = std::nullopt) const;
+    const Keyframe& getLastKeyframe() const;
+    // time of the keyframe after the given keyframe of this ball, nothing if
+    // it is the last one
+    std::optional<Time> getNextKeyframeTime(const Keyframe& keyframe) const;
     const double& getMass() const { return m_mass; }
     int getID() const { return m_id; }
 
-    double getKineticEnergy(Time time) const;
+    double getKineticEnergy(Time time
+        , std::optional<KeyframeCursor> cursor = std::nullopt) const;
     //void draw(const Window& window);
 
     // creates new keyframe
@@ -47,25 +70,38 @@ public:
     // deletes all keyframes and replaces them with the one given
     // USE CAREFULLY, CAN BREAK THINGS
     void purgeKeyframes(Keyframe replacement);
+    // deletes the oldest count keyframes. the last keyframe is always kept
+    void evictKeyframes(std::size_t count);
 
 private:
 
     double m_radius; // in meters
     double m_mass; // in kilograms
     SDL_Color m_color;
+    // only set when the ball is created, the tag index of the world relies
+    // on them never changing
+    TagSet m_tags;
 
+    // sorted by time, physics only ever adds keyframes at the end
     std::vector<Keyframe> m_keyframes;
+    // index of the keyframe each cursor found last
+    mutable std::array<std::size_t
+        , static_cast<std::size_t>(KeyframeCursor::count)> m_cursors;
 
     int m_id; // used to compare balls
 
+    // index of last keyframe at or before time, searching only [first, end)
+    std::size_t findKeyframe(Time time, std::size_t first, std::size_t end) const;
+
     Ball(double radius, Eigen::Vector2d position, double mass, Eigen::Vector2d velocity
         , SDL_Color color = {255, 255, 255, 255}, Time time = {}
-        , const std::deque<std::string>& tags = {})
-        : tags{tags}
-        , m_radius{radius}
+        , const TagSet& tags = {})
+        : m_radius{radius}
         , m_mass{mass}
         , m_color{color}
+        , m_tags{tags}
         , m_keyframes{{position, velocity, time}}
+        , m_cursors{}
         , m_id{newBallID()}
     {}
 
@@ -80,18 +116,119 @@ private:
 bool operator== (const Ball& a, const Ball& b);
 bool operator!= (const Ball& a, const Ball& b);
 
+// limits on how much keyframe history is kept. anything not set is not
+// limited. history the window is currently showing is never evicted
+struct KeyframeRetention
+{
+    // keep keyframes needed to show the last maxAge of simulation
+    std::optional<Time> maxAge{};
+    // keep at most this many keyframes per ball
+    std::optional<std::size_t> maxKeyframes{};
+    // keep keyframes of all balls together under this many bytes
+    std::optional<std::size_t> memoryBudget{};
+
+    bool isLimited() const { return maxAge || maxKeyframes || memoryBudget; }
+};
+
+// state of every ball at the end of its keyframe list, stored as separate
+// arrays so that physics can stream through it without touching the keyframe
+// history, tags or colors. index i belongs to ball i of the ball list
+struct HotState
+{
+    // start of the current trajectory segment, that is, the last keyframe
+    std::vector<double> positionX{};
+    std::vector<double> positionY{};
+    std::vector<double> velocityX{};
+    std::vector<double> velocityY{};
+    std::vector<Time> segmentStart{};
+
+    std::vector<double> radius{};
+    std::vector<double> mass{};
+    std::vector<int> id{};
+    // number of keyframes ever created for the ball. changes whenever the
+    // trajectory of the ball changes
+    std::vector<std::size_t> revision{};
+
+    std::size_t size() const { return id.size(); }
+
+    // position of ball i at a time within its current segment
+    Eigen::Vector2d getPosition(std::size_t i, Time time) const
+    {
+        const double dt{(time - segmentStart[i]).getS()};
+        return {positionX[i] + velocityX[i] * dt
+            , positionY[i] + velocityY[i] * dt};
+    }
+    Eigen::Vector2d getVelocity(std::size_t i) const
+        { return {velocityX[i], velocityY[i]}; }
+
+    // starts a new segment for ball i
+    void setSegment(std::size_t i, const Keyframe& keyframe);
+    // adds a ball at the end
+    void push(const Ball& ball);
+    // moves the last ball into place of ball i, like World::removeBall
+    void swapRemove(std::size_t i);
+    void reserve(std::size_t count);
+    void clear();
+};
+
+// everything needed to create a ball, for adding many at once
+struct BallSpec
+{
+    double radius{1};
+    Eigen::Vector2d position{0, 0};
+    double mass{1};
+    Eigen::Vector2d velocity{0, 0};
+    SDL_Color color{255, 255, 255, 255};
+    TagSet tags{};
+};
+
+// a ball newBalls couldn't add
+struct BallRejection
+{
+    // index into the list given to newBalls
+    std::size_t spec{};
+    // id of the ball it would overlap, nothing if it's out of bounds
+    std::optional<int> overlaps{};
+};
+
+// refers to a ball no matter how the ball list gets rearranged. handles to
+// deleted balls stay invalid even once their slot is reused, since reusing
+// a slot changes its generation
+struct BallHandle
+{
+    std::uint32_t slot{};
+    std::uint32_t generation{};
+};
+
 class World
 {
 public:
     // time up to which world state has been calculated
     Time endTime{};
 
-    std::atomic<bool> isBeingEdited{false};
+    // latest state of the world for the window. physics writes and the
+    // window reads it, each from its own thread, so it's usable through const
+    // worlds like a mutex would be
+    mutable SnapshotChannel snapshots{};
 
     // creates a new ball, adds it to the ball list
     Ball& newBall(double radius, Eigen::Vector2d position, double mass = 1
         , Eigen::Vector2d velocity = {0, 0}, SDL_Color color = {255, 255, 255, 255}
-        , Time time = {});
+        , Time time = {}, const TagSet& tags = {});
+    // same as newBall, but doesn't check for overlaps with other balls, which
+    // takes O(n). only for callers that place balls so that they can't overlap
+    Ball& newBallUnchecked(double radius, Eigen::Vector2d position
+        , double mass = 1, Eigen::Vector2d velocity = {0, 0}
+        , SDL_Color color = {255, 255, 255, 255}, Time time = {}
+        , const TagSet& tags = {});
+    // adds all balls at once, in order. overlaps are checked with a spatial
+    // hash instead of against every ball, so this is O(n) instead of O(n^2)
+    // for n balls. balls overlapping an earlier one (old or new) or out of
+    // bounds are skipped and returned
+    std::vector<BallRejection> newBalls(const std::vector<BallSpec>& balls
+        , Time time);
+    // makes room for more balls, so adding many of them doesn't reallocate
+    void reserveBalls(std::size_t count);
 
     // set the world bounds
     void setWorldBounds(const std::optional<Rect>& bounds, Time time);
@@ -104,14 +241,82 @@ public:
     // get a const reference to the ball list
     const std::vector<Ball>& getBalls() const { return m_balls; };
 
-    // get a modifiable (non-const) reference to the ball list
+    // get a modifiable (non-const) reference to the ball list. balls may be
+    // changed through it, but not added, removed or reordered
     std::vector<Ball>& getBallsModifiable() { return m_balls; };
+    // get the current state of all balls
+    const HotState& getHotState() const { return m_hot; }
+    // gives the ball at the given index a new keyframe. this must be used
+    // instead of Ball::newKeyframe so that the hot state stays up to date
+    void newKeyframe(std::size_t ball, const Keyframe& keyframe);
+    // deletes all keyframes, replacing them with the state of every ball at
+    // purgeTime moved to time 0
+    void purgeKeyframes(Time purgeTime);
+    // rebuilds the hot state from the last keyframe of every ball. needed
+    // after anything modifies the ball list directly
+    void syncHotState();
+
+    void setKeyframeRetention(const KeyframeRetention& retention)
+        { m_retention = retention; }
+    const KeyframeRetention& getKeyframeRetention() const { return m_retention; }
+    // evicts keyframes the retention policy doesn't allow anymore. now is the
+    // latest simulated time, keyframes needed to show oldestNeeded or
+    // anything after it are kept no matter what
+    void enforceKeyframeRetention(Time now, Time oldestNeeded);
+    // earliest time the state of every ball is known at
+    Time getHistoryStart() const;
+    // number of keyframes of all balls together
+    std::size_t getKeyframeCount() const;
+
+    // kinetic energy of all balls with the tag at endTime. a running sum is
+    // kept for every tag asked for once, updated with every new keyframe, so
+    // after the first call this is O(1)
+    double getCurrentKineticEnergy(std::string_view tag);
+    // calculates all running sums from scratch, which gets rid of rounding
+    // errors piled up by the updates. happens on its own every now and then
+    void recomputeKineticEnergy();
+
+    // handle of the ball at the given index of the ball list
+    BallHandle getHandle(std::size_t index) const;
+    // index of the ball in the ball list, nothing if it has been deleted
+    std::optional<std::size_t> getIndex(BallHandle handle) const;
+    // handle of the ball with the given ID, nothing if there is none
+    std::optional<BallHandle> findBall(int ID) const;
+
     // get a non-const reference to a ball with the given ID
     Ball& getBallByID(int ID);
+    // remove the ball with the given ID. the last ball of the ball list
+    // takes its place. O(1) apart from moving the tag index entries of the
+    // two balls
+    void deleteBall(int ID);
+    // removes all balls with the given IDs. returns the IDs that weren't
+    // found
+    std::vector<int> deleteBalls(const std::vector<int>& IDs);
+    // remove all balls
+    void clearBalls();
     // get all balls with specified tag
     std::vector<std::reference_wrapper<Ball>> getBallsWithTag(std::string_view tag);
+    // calls func(i) with the index of every ball with the tag, in order. only
+    // balls with the tag are touched. every ball has the empty tag
+    template <typename F>
+    void forEachBallWithTag(std::string_view tag, F&& func) const
+    {
+        if (tag.empty())
+        {
+            for (std::size_t i{0}; i < m_balls.size(); i++) { func(i); }
+            return;
+        }
+
+        const auto id{TagInterner::find(tag)};
+        if (!id || *id >= m_tagIndex.size()) { return; }
+        for (const auto i : m_tagIndex[*id]) { func(i); }
+    }
 
-    World() : m_balls{}, m_bounds{} {}
+    World() 
+        : m_balls{}, m_hot{}, m_bounds{}, m_retention{}, m_slots{}
+        , m_freeSlots{}, m_ballSlots{}, m_idSlots{}, m_tagIndex{}
+        , m_tagEnergy{}, m_energyUpdates{0}
+    {}
     ~World() = default;
 
     // no copying or moving worlds
@@ -123,7 +328,57 @@ public:
 
 private:
     std::vector<Ball> m_balls;
+    HotState m_hot;
     std::optional<Rect> m_bounds;
+    KeyframeRetention m_retention;
+
+    // slot map. a ball keeps its slot for as long as it exists, while its
+    // index changes whenever a ball before it is deleted
+    struct Slot
+    {
+        std::uint32_t generation{};
+        // index of the ball in the ball list, nothing if the slot is free
+        std::optional<std::size_t> ball{};
+    };
+    std::vector<Slot> m_slots;
+    std::vector<std::uint32_t> m_freeSlots;
+    // slot of every ball, index i belongs to ball i of the ball list
+    std::vector<std::uint32_t> m_ballSlots;
+    std::unordered_map<int, std::uint32_t> m_idSlots;
+    // gives the last ball of the ball list a slot
+    void assignSlot();
+    // swaps the ball with the last one and removes it, keeping the hot
+    // state, tag index and kinetic energy sums up to date
+    void removeBall(std::size_t index);
+
+    // indices of the balls with each tag, sorted, indexed by tag id
+    std::vector<std::vector<std::size_t>> m_tagIndex;
+    // adds the last ball of the ball list to the tag index
+    void indexLastBall();
+    void rebuildTagIndex();
+
+    struct TagEnergy
+    {
+        // nothing for the sum of all balls
+        std::optional<TagID> tag{};
+        double sum{};
+    };
+    std::vector<TagEnergy> m_tagEnergy;
+    // updates since the last recompute. the sums are recomputed after
+    // m_energyRecomputeInterval updates, or one per ball if there are more
+    // balls, so that recomputing stays O(1) per update on average
+    std::size_t m_energyUpdates;
+    static constexpr std::size_t m_energyRecomputeInterval{1 << 16};
+    // adds delta to the sum of every tag the ball has
+    void addKineticEnergy(const Ball& ball, double delta);
+    // same, without counting towards the next recompute
+    void shiftKineticEnergy(const Ball& ball, double delta);
+
+    // latest time before oldestNeeded at which the keyframes left over after
+    // eviction fit into the memory budget
+    Time findBudgetCutoff(std::size_t maxKeyframes, Time oldestNeeded) const;
+    // keyframes of a ball kept after eviction if everything before time goes
+    static std::size_t keptAfter(const Ball& ball, Time time);
 };
 
 enum class WorldException
@@ -0,0 +1,108 @@
+#include "circle_atlas.hpp"
+#include "debug.hpp"
+
+CircleAtlas::CircleAtlas(SDL_Renderer* renderer)
+    : m_texture{SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32
+        , SDL_TEXTUREACCESS_STATIC, m_size, m_size)}
+    , m_sprites{}
+    , m_shelfX{0}
+    , m_shelfY{0}
+    , m_shelfHeight{0}
+    , m_pixels{}
+    , m_hits{0}
+    , m_misses{0}
+    , m_spriteCount{0}
+{
+    if (m_texture == nullptr)
+    {
+        Debug::log("Couldn't create circle atlas, drawing circles directly.");
+        return;
+    }
+    SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND);
+}
+
+CircleAtlas::~CircleAtlas()
+{
+    if (m_texture != nullptr) { SDL_DestroyTexture(m_texture); }
+}
+
+std::optional<SDL_Rect> CircleAtlas::get(int radius, SDL_Color color)
+{
+    const std::uint64_t key{makeKey(radius, color)};
+    if (const auto it{m_sprites.find(key)}; it != m_sprites.end())
+    {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second;
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+
+    // a pixel of room on each side for the antialiased edge
+    const int size{2 * radius + 2};
+    if (m_shelfX + size > m_size)
+    {
+        m_shelfX = 0;
+        m_shelfY += m_shelfHeight;
+        m_shelfHeight = 0;
+    }
+    if (m_shelfY + size > m_size) { return std::nullopt; }
+
+    const SDL_Rect area{m_shelfX, m_shelfY, size, size};
+    m_shelfX += size;
+    m_shelfHeight = std::max(m_shelfHeight, size);
+
+    rasterise(radius, color, area);
+    m_sprites.emplace(key, area);
+    m_spriteCount = m_sprites.size();
+    return area;
+}
+
+void CircleAtlas::clear()
+{
+    m_sprites.clear();
+    m_spriteCount = 0;
+    m_shelfX = 0;
+    m_shelfY = 0;
+    m_shelfHeight = 0;
+}
+
+void CircleAtlas::resetStats()
+{
+    m_hits = 0;
+    m_misses = 0;
+}
+
+std::uint64_t CircleAtlas::makeKey(int radius, SDL_Color color)
+{
+    return static_cast<std::uint64_t>(radius) << 32
+        | static_cast<std::uint64_t>(color.r) << 24
+        | static_cast<std::uint64_t>(color.g) << 16
+        | static_cast<std::uint64_t>(color.b) << 8
+        | static_cast<std::uint64_t>(color.a);
+}
+
+void CircleAtlas::rasterise(int radius, SDL_Color color, const SDL_Rect& area)
+{
+    const auto size{static_cast<std::size_t>(area.w)};
+    m_pixels.assign(size * size * 4, 0);
+
+    const double center{static_cast<double>(area.w) / 2};
+    for (std::size_t y{0}; y < size; y++)
+    {
+        for (std::size_t x{0}; x < size; x++)
+        {
+            // share of the pixel covered by the circle, roughly
+            const double dx{static_cast<double>(x) + 0.5 - center};
+            const double dy{static_cast<double>(y) + 0.5 - center};
+            const double coverage{std::clamp(radius + 0.5
+                - std::sqrt(dx * dx + dy * dy), 0.0, 1.0)};
+
+            Uint8* pixel{&m_pixels[(y * size + x) * 4]};
+            pixel[0] = color.r;
+            pixel[1] = color.g;
+            pixel[2] = color.b;
+            pixel[3] = static_cast<Uint8>(coverage * color.a);
+        }
+    }
+
+    SDL_UpdateTexture(m_texture, &area, m_pixels.data(), area.w * 4);
+}
@@ -0,0 +1,222 @@
+#include "collision.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using Eigen::Vector2d;
+
+std::optional<double> Collision::ballBallTime(const Vector2d& relativePosition
+    , const Vector2d& relativeVelocity, double distance)
+{
+    // solving |p + v*t| = d for t gives a*t^2 + 2*b*t + c = 0
+    const double a{relativeVelocity.squaredNorm()};
+    const double b{relativePosition.dot(relativeVelocity)};
+    const double c{relativePosition.squaredNorm() - distance * distance};
+
+    // moving apart (or not moving at all)
+    if (b >= 0) { return std::nullopt; }
+
+    // already touching and approaching
+    if (c <= 0) { return 0.0; }
+
+    const double discriminant{b * b - a * c};
+    if (discriminant < 0) { return std::nullopt; }
+
+    // smaller root, written so that it doesn't lose precision when b*b is
+    // much larger than a*c
+    return c / (-b + std::sqrt(discriminant));
+}
+
+std::optional<std::pair<double, Direction>> Collision::ballWallTime
+    (const Vector2d& position, const Vector2d& velocity, Rect collisionBounds)
+{
+    std::optional<std::pair<double, Direction>> r{};
+
+    auto consider{[&r](double distance, double speed, Direction dir)
+    {
+        // not moving towards this wall
+        if (speed <= 0) { return; }
+
+        const double t{std::max(0.0, distance / speed)};
+        if (!r || t < r->first) { r = {t, dir}; }
+    }};
+
+    consider(collisionBounds.getRight() - position.x(), velocity.x()
+        , Direction::right);
+    consider(position.x() - collisionBounds.getLeft(), -velocity.x()
+        , Direction::left);
+    consider(position.y() - collisionBounds.getTop(), -velocity.y()
+        , Direction::up);
+    consider(collisionBounds.getBottom() - position.y(), velocity.y()
+        , Direction::down);
+
+    return r;
+}
+
+namespace
+{
+    bool isHit(double x, double y, double radius, double candidateX
+        , double candidateY, double candidateRadius, double touchMargin)
+    {
+        const double dx{x - candidateX};
+        const double dy{y - candidateY};
+        const double reach{radius + candidateRadius
+            + std::max(radius, candidateRadius) * touchMargin};
+
+        return dx * dx + dy * dy <= reach * reach;
+    }
+
+    std::size_t narrowPhaseScalar(double x, double y, double radius
+        , const double* candidateX, const double* candidateY
+        , const double* candidateRadius, std::size_t count, double touchMargin
+        , std::uint32_t* hits)
+    {
+        std::size_t n{0};
+        for (std::size_t i{0}; i < count; i++)
+        {
+            if (isHit(x, y, radius, candidateX[i], candidateY[i]
+                , candidateRadius[i], touchMargin))
+            {
+                hits[n++] = static_cast<std::uint32_t>(i);
+            }
+        }
+        return n;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // writes the lanes set in mask as hits, starting at candidate index first
+    std::size_t writeHits(int mask, std::size_t first, std::uint32_t* hits)
+    {
+        std::size_t n{0};
+        while (mask != 0)
+        {
+            hits[n++] = static_cast<std::uint32_t>(first
+                + static_cast<std::size_t>(__builtin_ctz(
+                    static_cast<unsigned int>(mask))));
+            mask &= mask - 1;
+        }
+        return n;
+    }
+
+    __attribute__((target("sse2")))
+    std::size_t narrowPhaseSSE2(double x, double y, double radius
+        , const double* candidateX, const double* candidateY
+        , const double* candidateRadius, std::size_t count, double touchMargin
+        , std::uint32_t* hits)
+    {
+        const __m128d ax{_mm_set1_pd(x)};
+        const __m128d ay{_mm_set1_pd(y)};
+        const __m128d ar{_mm_set1_pd(radius)};
+        const __m128d margin{_mm_set1_pd(touchMargin)};
+
+        std::size_t n{0};
+        std::size_t i{0};
+        for (; i + 2 <= count; i += 2)
+        {
+            const __m128d br{_mm_loadu_pd(candidateRadius + i)};
+            const __m128d dx{_mm_sub_pd(ax, _mm_loadu_pd(candidateX + i))};
+            const __m128d dy{_mm_sub_pd(ay, _mm_loadu_pd(candidateY + i))};
+            const __m128d reach{_mm_add_pd(_mm_add_pd(ar, br)
+                , _mm_mul_pd(_mm_max_pd(ar, br), margin))};
+
+            const __m128d hit{_mm_cmple_pd(
+                _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))
+                , _mm_mul_pd(reach, reach))};
+
+            n += writeHits(_mm_movemask_pd(hit), i, hits + n);
+        }
+
+        for (; i < count; i++)
+        {
+            if (isHit(x, y, radius, candidateX[i], candidateY[i]
+                , candidateRadius[i], touchMargin))
+            {
+                hits[n++] = static_cast<std::uint32_t>(i);
+            }
+        }
+        return n;
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t narrowPhaseAVX2(double x, double y, double radius
+        , const double* candidateX, const double* candidateY
+        , const double* candidateRadius, std::size_t count, double touchMargin
+        , std::uint32_t* hits)
+    {
+        const __m256d ax{_mm256_set1_pd(x)};
+        const __m256d ay{_mm256_set1_pd(y)};
+        const __m256d ar{_mm256_set1_pd(radius)};
+        const __m256d margin{_mm256_set1_pd(touchMargin)};
+
+        std::size_t n{0};
+        std::size_t i{0};
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m256d br{_mm256_loadu_pd(candidateRadius + i)};
+            const __m256d dx{_mm256_sub_pd(ax, _mm256_loadu_pd(candidateX + i))};
+            const __m256d dy{_mm256_sub_pd(ay, _mm256_loadu_pd(candidateY + i))};
+            const __m256d reach{_mm256_add_pd(_mm256_add_pd(ar, br)
+                , _mm256_mul_pd(_mm256_max_pd(ar, br), margin))};
+
+            const __m256d hit{_mm256_cmp_pd(
+                _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))
+                , _mm256_mul_pd(reach, reach), _CMP_LE_OQ)};
+
+            n += writeHits(_mm256_movemask_pd(hit), i, hits + n);
+        }
+
+        for (; i < count; i++)
+        {
+            if (isHit(x, y, radius, candidateX[i], candidateY[i]
+                , candidateRadius[i], touchMargin))
+            {
+                hits[n++] = static_cast<std::uint32_t>(i);
+            }
+        }
+        return n;
+    }
+#endif
+}
+
+Collision::NarrowPhase Collision::getNarrowPhase(Kernel kernel)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (isSupported(kernel))
+    {
+        switch (kernel)
+        {
+        case Kernel::AVX2:
+            return narrowPhaseAVX2;
+        case Kernel::SSE2:
+            return narrowPhaseSSE2;
+        case Kernel::Scalar:
+            break;
+        }
+    }
+#endif
+    return narrowPhaseScalar;
+}
+
+bool Collision::isSupported(Kernel kernel)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    switch (kernel)
+    {
+    case Kernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case Kernel::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case Kernel::Scalar:
+        return true;
+    }
+#endif
+    return kernel == Kernel::Scalar;
+}
+
+Collision::Kernel Collision::getBestKernel()
+{
+    if (isSupported(Kernel::AVX2)) { return Kernel::AVX2; }
+    if (isSupported(Kernel::SSE2)) { return Kernel::SSE2; }
+    return Kernel::Scalar;
+}
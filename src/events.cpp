@@ -0,0 +1,18 @@
+#include "events.hpp"
+
+std::optional<CollisionEvent> EventQueue::peek(const HotState& balls)
+{
+    while (!m_queue.empty())
+    {
+        const CollisionEvent& e{m_queue.top()};
+
+        if (e.ballA < balls.size() && e.ballB < balls.size()
+            && balls.revision[e.ballA] == e.revisionA
+            && balls.revision[e.ballB] == e.revisionB)
+        {
+            return e;
+        }
+        m_queue.pop();
+    }
+    return std::nullopt;
+}
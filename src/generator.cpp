@@ -0,0 +1,199 @@
+#include "generator.hpp"
+#include <random>
+
+namespace
+{
+double pick(const ValueRange& range, std::mt19937_64& engine)
+{
+    if (range.min >= range.max) { return range.min; }
+    return std::uniform_real_distribution<double>{range.min, range.max}(engine);
+}
+}
+
+std::vector<BallSpec> BallGenerator::generate(const GeneratorSettings& settings
+    , Rect area, const std::vector<Obstacle>& obstacles)
+{
+    const double left{area.getLeft()};
+    const double top{area.getTop()};
+    const double width{std::abs(area.w)};
+    const double height{std::abs(area.h)};
+    double maxRadius{std::max(settings.radius.min, settings.radius.max)};
+    for (const auto& o : obstacles) { maxRadius = std::max(maxRadius, o.radius); }
+
+    if (settings.count == 0 || width <= 0 || height <= 0) { return {}; }
+
+    // cells at least as wide as the biggest ball, so that overlapping balls
+    // are always in the same or neighbouring cells. made wider if that would
+    // mean lots more cells than balls
+    const double cellSize{std::max({2 * maxRadius, 1e-9, std::sqrt(width
+        * height / (4 * static_cast<double>(settings.count)))})};
+    const auto columns{static_cast<std::size_t>(std::max(1.0
+        , std::ceil(width / cellSize)))};
+    const auto rows{static_cast<std::size_t>(std::max(1.0
+        , std::ceil(height / cellSize)))};
+
+    // tiles are squares of tileCells cells
+    const auto tileCells{static_cast<std::size_t>(std::max(1.0, std::ceil(
+        std::sqrt(static_cast<double>(columns * rows) / m_targetTiles))))};
+    const std::size_t tileColumns{(columns + tileCells - 1) / tileCells};
+    const std::size_t tileRows{(rows + tileCells - 1) / tileCells};
+    const double tileSize{static_cast<double>(tileCells) * cellSize};
+
+    // how many balls each tile gets, proportional to its area. rounding the
+    // running total makes them add up to exactly count
+    std::vector<std::size_t> targets(tileColumns * tileRows, 0);
+    {
+        double totalArea{0};
+        std::size_t placed{0};
+        for (std::size_t t{0}; t < targets.size(); t++)
+        {
+            const double w{std::min(tileSize, width
+                - static_cast<double>(t % tileColumns) * tileSize)};
+            const double h{std::min(tileSize, height
+                - static_cast<double>(t / tileColumns) * tileSize)};
+            totalArea += w * h;
+
+            const auto total{static_cast<std::size_t>(std::llround(totalArea
+                / (width * height) * static_cast<double>(settings.count)))};
+            targets[t] = std::min(total, settings.count) - placed;
+            placed += targets[t];
+        }
+    }
+
+    // balls in each cell, as tile << 32 | index in that tile's list. the
+    // obstacles go into an extra tile after the real ones, which is never
+    // filled
+    std::vector<std::vector<std::uint64_t>> cells(columns * rows);
+    std::vector<std::vector<BallSpec>> tiles(targets.size() + 1);
+
+    const auto getCell{[&](double position, double start, std::size_t count)
+    {
+        const double cell{std::floor((position - start) / cellSize)};
+        return static_cast<std::size_t>(std::clamp(cell, 0.0
+            , static_cast<double>(count - 1)));
+    }};
+
+    const auto fillTile{[&](std::size_t tile)
+    {
+        std::seed_seq seeds{static_cast<std::uint32_t>(settings.seed)
+            , static_cast<std::uint32_t>(settings.seed >> 32)
+            , static_cast<std::uint32_t>(tile)};
+        std::mt19937_64 engine{seeds};
+
+        const double tileLeft{left
+            + static_cast<double>(tile % tileColumns) * tileSize};
+        const double tileTop{top
+            + static_cast<double>(tile / tileColumns) * tileSize};
+        std::uniform_real_distribution<double> x{tileLeft
+            , std::min(tileLeft + tileSize, left + width)};
+        std::uniform_real_distribution<double> y{tileTop
+            , std::min(tileTop + tileSize, top + height)};
+
+        auto& balls{tiles[tile]};
+        balls.reserve(targets[tile]);
+        std::size_t failures{0};
+        while (balls.size() < targets[tile] && failures < m_maxAttempts)
+        {
+            const double radius{pick(settings.radius, engine)};
+            const Eigen::Vector2d position{x(engine), y(engine)};
+
+            if (position.x() - radius < left || position.x() + radius > left + width
+                || position.y() - radius < top || position.y() + radius > top + height)
+            {
+                failures++;
+                continue;
+            }
+
+            const std::size_t column{getCell(position.x(), left, columns)};
+            const std::size_t row{getCell(position.y(), top, rows)};
+
+            bool overlaps{false};
+            for (std::size_t r{row > 0 ? row - 1 : 0};
+                r <= std::min(row + 1, rows - 1) && !overlaps; r++)
+            {
+                for (std::size_t c{column > 0 ? column - 1 : 0};
+                    c <= std::min(column + 1, columns - 1) && !overlaps; c++)
+                {
+                    for (const auto other : cells[r * columns + c])
+                    {
+                        const BallSpec& b{tiles[other >> 32][other & 0xffffffff]};
+                        const double distance{b.radius + radius};
+                        if ((b.position - position).squaredNorm()
+                            <= distance * distance)
+                        {
+                            overlaps = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (overlaps)
+            {
+                failures++;
+                continue;
+            }
+            failures = 0;
+
+            cells[row * columns + column].push_back(
+                static_cast<std::uint64_t>(tile) << 32 | balls.size());
+            balls.push_back({radius, position, 1, {0, 0}, settings.color
+                , settings.tags});
+        }
+
+        for (auto& b : balls)
+        {
+            b.mass = pick(settings.mass, engine);
+            if (settings.temperature > 0 && b.mass > 0)
+            {
+                std::normal_distribution<double> component{0
+                    , std::sqrt(settings.temperature / b.mass)};
+                b.velocity = {component(engine), component(engine)};
+            }
+        }
+    }};
+
+    auto& obstacleTile{tiles.back()};
+    for (const auto& o : obstacles)
+    {
+        // ones outside the area can still reach into it
+        if (o.position.x() + o.radius < left || o.position.x() - o.radius > left + width
+            || o.position.y() + o.radius < top || o.position.y() - o.radius > top + height)
+        {
+            continue;
+        }
+
+        cells[getCell(o.position.y(), top, rows) * columns
+            + getCell(o.position.x(), left, columns)].push_back(
+                static_cast<std::uint64_t>(targets.size()) << 32 
+                | obstacleTile.size());
+        obstacleTile.push_back({o.radius, o.position});
+    }
+
+    // tiles in the same pass are never next to each other, so they only ever
+    // look at cells of tiles filled in earlier passes
+    for (std::size_t pass{0}; pass < 4; pass++)
+    {
+        std::vector<std::size_t> passTiles{};
+        for (std::size_t t{0}; t < targets.size(); t++)
+        {
+            if ((t % tileColumns) % 2 == pass % 2
+                && (t / tileColumns) % 2 == pass / 2)
+            {
+                passTiles.push_back(t);
+            }
+        }
+
+        m_workers.run(passTiles.size(), [&](std::size_t task, std::size_t)
+        {
+            fillTile(passTiles[task]);
+        });
+    }
+
+    std::vector<BallSpec> balls{};
+    balls.reserve(settings.count);
+    for (std::size_t t{0}; t < targets.size(); t++)
+    {
+        std::move(tiles[t].begin(), tiles[t].end(), std::back_inserter(balls));
+    }
+    return balls;
+}
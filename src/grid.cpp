@@ -0,0 +1,155 @@
+#include "grid.hpp"
+
+using Eigen::Vector2d;
+
+void UniformGrid::update(const HotState& balls
+    , const std::optional<Rect>& bounds, Time time, double margin)
+{
+    m_positions.resize(balls.size());
+
+    double maxRadius{0};
+    // cells wider than needed only cost extra candidate pairs, so the grid
+    // is not rebuilt when the margin shrinks
+    bool layoutValid{balls.size() == m_ballIDs.size() && margin <= m_margin
+        && !m_cells.empty()};
+
+    // bounds can't be compared directly, so compare every field
+    if (bounds.has_value() != m_bounds.has_value()) { layoutValid = false; }
+    else if (bounds && (bounds->x != m_bounds->x || bounds->y != m_bounds->y
+        || bounds->w != m_bounds->w || bounds->h != m_bounds->h))
+    {
+        layoutValid = false;
+    }
+
+    for (std::size_t i{0}; i < balls.size(); i++)
+    {
+        m_positions[i] = balls.getPosition(i, time);
+        maxRadius = std::max(maxRadius, balls.radius[i]);
+
+        if (layoutValid && balls.id[i] != m_ballIDs[i]) { layoutValid = false; }
+    }
+    if (maxRadius != m_maxRadius) { layoutValid = false; }
+
+    if (!layoutValid)
+    {
+        m_maxRadius = maxRadius;
+        rebuild(balls, bounds, margin);
+        return;
+    }
+
+    for (std::size_t i{0}; i < balls.size(); i++)
+    {
+        // without bounds the grid only covers the area the balls were in at
+        // the last rebuild, so a ball leaving it means the grid is outdated
+        if (!m_bounds && !isInsideGrid(m_positions[i]))
+        {
+            rebuild(balls, bounds, margin);
+            return;
+        }
+
+        const std::size_t cell{getCell(m_positions[i])};
+        if (cell == m_ballCell[i]) { continue; }
+
+        remove(i);
+        insert(i, cell);
+    }
+}
+
+void UniformGrid::rebuild(const HotState& balls
+    , const std::optional<Rect>& bounds, double margin)
+{
+    m_bounds = bounds;
+    m_margin = margin * m_marginHeadroom;
+    m_cellSize = 2 * m_maxRadius + m_margin;
+    if (m_cellSize <= 0) { m_cellSize = 1; }
+
+    // area covered by the grid
+    Rect area{};
+    if (bounds)
+    {
+        area = {bounds->x, bounds->y, bounds->w, bounds->h};
+        area = {area.getLeft(), area.getTop()
+            , area.getRight() - area.getLeft()
+            , area.getBottom() - area.getTop()};
+    }
+    else if (!m_positions.empty())
+    {
+        Vector2d min{m_positions[0]};
+        Vector2d max{m_positions[0]};
+        for (const auto& p : m_positions)
+        {
+            min = min.cwiseMin(p);
+            max = max.cwiseMax(p);
+        }
+        area = {min.x(), min.y(), max.x() - min.x(), max.y() - min.y()};
+    }
+
+    const std::size_t maxCells
+        {std::max<std::size_t>(16, balls.size() * m_maxCellsPerBall)};
+    double columns{std::max(1.0, std::ceil(area.w / m_cellSize))};
+    double rows{std::max(1.0, std::ceil(area.h / m_cellSize))};
+
+    // grid too fine, make cells bigger
+    if (columns * rows > static_cast<double>(maxCells))
+    {
+        m_cellSize *= std::sqrt(columns * rows / static_cast<double>(maxCells));
+        columns = std::max(1.0, std::ceil(area.w / m_cellSize));
+        rows = std::max(1.0, std::ceil(area.h / m_cellSize));
+    }
+
+    m_columns = static_cast<int>(columns);
+    m_rows = static_cast<int>(rows);
+    m_origin = {area.x, area.y};
+
+    m_cells.assign(static_cast<std::size_t>(m_columns * m_rows), {});
+    m_ballCell.resize(balls.size());
+    m_ballSlot.resize(balls.size());
+    m_ballIDs.resize(balls.size());
+
+    for (std::size_t i{0}; i < balls.size(); i++)
+    {
+        m_ballIDs[i] = balls.id[i];
+        insert(i, getCell(m_positions[i]));
+    }
+}
+
+std::size_t UniformGrid::getCell(const Vector2d& position) const
+{
+    // balls slightly outside the grid are clamped to the edge cells. this
+    // never separates touching balls by more than one cell
+    const int x{std::clamp(static_cast<int>(
+        std::floor((position.x() - m_origin.x()) / m_cellSize))
+        , 0, m_columns - 1)};
+    const int y{std::clamp(static_cast<int>(
+        std::floor((position.y() - m_origin.y()) / m_cellSize))
+        , 0, m_rows - 1)};
+
+    return static_cast<std::size_t>(y * m_columns + x);
+}
+
+bool UniformGrid::isInsideGrid(const Vector2d& position) const
+{
+    const Vector2d relative{position - m_origin};
+
+    return relative.x() >= 0 && relative.y() >= 0
+        && relative.x() <= m_columns * m_cellSize
+        && relative.y() <= m_rows * m_cellSize;
+}
+
+void UniformGrid::insert(std::size_t ball, std::size_t cell)
+{
+    m_ballCell[ball] = cell;
+    m_ballSlot[ball] = m_cells[cell].size();
+    m_cells[cell].push_back(ball);
+}
+
+void UniformGrid::remove(std::size_t ball)
+{
+    auto& cell{m_cells[m_ballCell[ball]]};
+    const std::size_t slot{m_ballSlot[ball]};
+
+    // swap with last ball in cell so removal doesn't shift anything
+    cell[slot] = cell.back();
+    m_ballSlot[cell[slot]] = slot;
+    cell.pop_back();
+}
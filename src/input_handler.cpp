@@ -10,8 +10,14 @@ string InputHandler::m_helpText
     "graphics\n"
 };
 
-std::vector<std::pair<Time, COMMAND>> InputHandler::wait::m_phys{};
-std::vector<std::pair<Time, COMMAND>> InputHandler::wait::m_time{};
+InputHandler::wait::Queue InputHandler::wait::m_phys{};
+InputHandler::wait::Queue InputHandler::wait::m_time{};
+std::uint64_t InputHandler::wait::m_queued{0};
+
+std::vector<BallSpec> InputHandler::batch::m_newBalls{};
+std::vector<int> InputHandler::batch::m_deletedIDs{};
+bool InputHandler::batch::m_open{false};
+Time InputHandler::batch::m_time{};
 
 std::optional<std::reference_wrapper<World>>    InputHandler::m_world{};
 std::optional<std::reference_wrapper<Window>>   InputHandler::m_window{};
@@ -39,9 +45,21 @@ void InputHandler::parseInput(string inputCommand)
 
     runCommand(command);
 }
-void InputHandler::runCommand(COMMAND& command)
+void InputHandler::runCommand(COMMAND& command, bool publish)
 {
-    WORLD.isBeingEdited = true;
+    // the whole command goes into the trace, it's gone once it has run
+    std::optional<Tracer::Clock::time_point> traceStart{};
+    string traceDetail{};
+    if (Tracer::isEnabled())
+    {
+        traceStart = Tracer::Clock::now();
+        for (COMMAND c{command}; !c.empty(); c.pop())
+        {
+            if (!traceDetail.empty()) { traceDetail += ' '; }
+            traceDetail += c.front();
+        }
+    }
+
     try
     {
     string front{dequeue(command)};
@@ -52,6 +70,8 @@ void InputHandler::runCommand(COMMAND& command)
     else if (front == "physics" || front == "p") { physics::parse(command);}
     else if (front == "load"    || front == "l") { load   ::parse(command);}
     else if (front == "wait"    || front == "w") { wait   ::parse(command);}
+    else if (front == "batch"   || front =="ba") { batch  ::parse(command);}
+    else if (front == "trace"   || front =="tr") { trace  ::parse(command);}
     else if (front == "quit"    || front == "q") { STATE = AppState::quit; }
     else { Debug::err("Invalid command"); }
     }
@@ -59,31 +79,26 @@ void InputHandler::runCommand(COMMAND& command)
     {
         Debug::err("Something is wrong with your command :(");
     }
-    WORLD.isBeingEdited = false;
+    // the window only sees what physics publishes, so edits have to be
+    // published right away, even while the window time stands still. staged
+    // edits change nothing until the batch is committed
+    if (publish && !batch::isOpen()) { PHYS.publishSnapshot(); }
+
+    if (traceStart)
+    {
+        Tracer::record("command", *traceStart, Tracer::Clock::now()
+            , traceDetail);
+    }
 }
 void InputHandler::checkWaiting()
 {
-    int i{-1};
-    for (auto& c : wait::m_phys)
-    {
-        i++;
+    std::vector<COMMAND> due{wait::takeDue(PHYS.getSimulationTime()
+        , WINDOW.getTime())};
+    if (due.empty()) { return; }
 
-        if (c.first > PHYS.getSimulationTime()) { continue; }
-
-        runCommand(c.second);
-
-        wait::m_phys.erase(wait::m_phys.begin() + i);
-    }
-
-    int j{-1};
-    for (auto& c : wait::m_time)
-    {
-        if (c.first > WINDOW.getTime()) { continue; }
-
-        runCommand(c.second);
-
-        wait::m_time.erase(wait::m_time.begin() + j);
-    }
+    // everything due now runs as one batch, published once
+    for (auto& c : due) { runCommand(c, false); }
+    if (!batch::isOpen()) { PHYS.publishSnapshot(); }
 }
 
 double InputHandler::makeDouble(string str, double min, double max)
@@ -173,6 +188,19 @@ SDL_Color InputHandler::makeColor(std::string colorString)
     return {static_cast<Uint8>(r), static_cast<Uint8>(g), static_cast<Uint8>(b)
         , static_cast<Uint8>(a)};
 }
+ValueRange InputHandler::makeRange(std::string rangeString, double min)
+{
+    queue<string> values{splitString(rangeString, ';')};
+    if (1 > values.size() || values.size() > 2) 
+        { throw CommandException::WrongParameter; }
+
+    ValueRange range{};
+    range.min = makeDouble(dequeue(values), min);
+    range.max = values.empty() ? range.min : makeDouble(dequeue(values), min);
+
+    if (range.min > range.max) { throw CommandException::WrongParameter; }
+    return range;
+}
 
 void InputHandler::outTime(Time time, COMMAND& command)
 {
@@ -209,13 +237,27 @@ void InputHandler::time::parse(COMMAND& command)
 
 void InputHandler::time::set(COMMAND& command)
 {
-    WINDOW.setTime(makeTime(dequeue(command)));
+    setWindowTime(makeTime(dequeue(command)));
 }
 void InputHandler::time::move(COMMAND& command)
 {
     string t{command.front()};
 
-    WINDOW.setTime(WINDOW.getTime() + makeTime(t, true));
+    setWindowTime(WINDOW.getTime() + makeTime(t, true));
+}
+void InputHandler::time::setWindowTime(Time newTime)
+{
+    const Time historyStart{WORLD.getHistoryStart()};
+    if (newTime < historyStart)
+    {
+        Debug::err("Time " + std::to_string(newTime.getS()) + " s is no longer"
+            " in history, the earliest time available is " 
+            + std::to_string(historyStart.getS()) + " s. See physics"
+            " retention.");
+        return;
+    }
+
+    WINDOW.setTime(newTime);
 }
 void InputHandler::time::get(COMMAND& command)
 {
@@ -256,6 +298,7 @@ void InputHandler::balls::parse(COMMAND& command)
             " kinetic energy.");
     }
     else if (front == "new"    || front == "n") { newball   (command); }
+    else if (front == "generate" || front == "gen") { generate(command); }
     else if (front == "delete" || front == "d") { deleteball(command); }
     else if (front == "clear"  || front == "c") { clear     ();        }
     else { throw CommandException::WrongArgument; }
@@ -280,9 +323,9 @@ void InputHandler::balls::get(COMMAND& command)
         if(unprefix(front, "tag=") || unprefix(front, "t=")) { tag = front; }
     }
 
-    for (const auto& b : WORLD.getBalls())
+    WORLD.forEachBallWithTag(tag, [](std::size_t i)
     {
-        if (!tag.empty() && !b.hasTag(tag)) { continue; }
+        const Ball& b{WORLD.getBalls()[i]};
 
         const Eigen::Vector2d& position{b.getPositionAtTime(WINDOW.getTime())};
         const Eigen::Vector2d& velocity{b.getLastKeyframeBeforeTime
@@ -308,7 +351,7 @@ void InputHandler::balls::get(COMMAND& command)
             + "velocity: " + addSpacing(velocityX + ";" + velocityY, 24) 
             + "color: " + addSpacing(cR + ";" + cG + ";" + cB, 24) 
             + "tags: " + b.getTagsAsString() + "\n");
-    }
+    });
 }
 void InputHandler::balls::newball(COMMAND& command)
 {
@@ -318,7 +361,7 @@ void InputHandler::balls::newball(COMMAND& command)
     Eigen::Vector2d velocity{0, 0};
     SDL_Color color{255, 255, 255, 255};
     Time time{WINDOW.getTime()};
-    std::deque<string> tags{};
+    TagSet tags{};
     while (!command.empty())
     {
         string param{dequeue(command)};
@@ -337,10 +380,16 @@ void InputHandler::balls::newball(COMMAND& command)
             { tags = Ball::getTagsFromString(param); }
     }
 
+    if (batch::isOpen())
+    {
+        batch::m_newBalls.push_back({radius, position, mass, velocity, color
+            , std::move(tags)});
+        return;
+    }
+
     try
     {
-    auto& b = WORLD.newBall(radius, position, mass, velocity, color, time);
-    b.tags = tags;
+    WORLD.newBall(radius, position, mass, velocity, color, time, tags);
 
     WINDOW.setTime({});
     PHYS.purgeKeyframes(time);
@@ -351,6 +400,84 @@ void InputHandler::balls::newball(COMMAND& command)
             " such as inside another ball or outside the world bounds.");
     }
 }
+void InputHandler::balls::generate(COMMAND& command)
+{
+    GeneratorSettings settings{};
+    while (!command.empty())
+    {
+        string param{dequeue(command)};
+
+        if      (unprefix(param, "count=")       || unprefix(param, "n="))
+            { settings.count = static_cast<std::size_t>(makeInt(param, 0)); }
+        else if (unprefix(param, "radius=")      || unprefix(param, "r="))
+            { settings.radius = makeRange(param); }
+        else if (unprefix(param, "mass=")        || unprefix(param, "m="))
+            { settings.mass = makeRange(param); }
+        else if (unprefix(param, "temperature=") || unprefix(param, "temp="))
+            { settings.temperature = makeDouble(param, 0); }
+        else if (unprefix(param, "seed=")        || unprefix(param, "s="))
+            { settings.seed = static_cast<std::uint64_t>(makeInt(param, 0)); }
+        else if (unprefix(param, "color=")       || unprefix(param, "c="))
+            { settings.color = makeColor(param); }
+        else if (unprefix(param, "tags=")        || unprefix(param, "t="))
+            { settings.tags = Ball::getTagsFromString(param); }
+    }
+
+    if (!WORLD.getWorldBounds())
+    {
+        Debug::err("Balls can only be generated inside world bounds.");
+        return;
+    }
+
+    // balls that are there when the new ones get added, which they must not
+    // overlap. those staged for deletion are gone by then
+    const Time time{batch::isOpen() ? batch::getTime() : WINDOW.getTime()};
+    if (time < WORLD.getHistoryStart())
+    {
+        Debug::err("Balls can't be generated at " + std::to_string(time.getS())
+            + " s, which is no longer in history.");
+        return;
+    }
+
+    const std::unordered_set<int> deleted{batch::m_deletedIDs.begin()
+        , batch::m_deletedIDs.end()};
+    std::vector<Obstacle> obstacles{};
+    obstacles.reserve(WORLD.getBalls().size() + batch::m_newBalls.size());
+    for (const auto& b : WORLD.getBalls())
+    {
+        if (deleted.contains(b.getID())) { continue; }
+        obstacles.push_back({b.getPositionAtTime(time), b.getRadius()});
+    }
+    for (const auto& b : batch::m_newBalls)
+    {
+        obstacles.push_back({b.position, b.radius});
+    }
+
+    std::vector<BallSpec> balls{BallGenerator{PHYS.getWorkers()}.generate(
+        settings, WORLD.getWorldBounds().value(), obstacles)};
+    if (balls.size() < settings.count)
+    {
+        Debug::err("Only found room for " + std::to_string(balls.size()) 
+            + " of " + std::to_string(settings.count) + " balls.");
+    }
+
+    if (batch::isOpen())
+    {
+        std::move(balls.begin(), balls.end()
+            , std::back_inserter(batch::m_newBalls));
+        return;
+    }
+
+    const std::size_t skipped{WORLD.newBalls(balls, time).size()};
+    if (skipped > 0)
+    {
+        Debug::err(std::to_string(skipped) + " generated balls overlapped"
+            " existing ones and were left out.");
+    }
+
+    WINDOW.setTime({});
+    PHYS.purgeKeyframes(time);
+}
 void InputHandler::balls::deleteball(COMMAND& command)
 {
     string front{dequeue(command)};
@@ -358,32 +485,37 @@ void InputHandler::balls::deleteball(COMMAND& command)
 
     if (unprefix(front, "id="))
     {
-        queue<string> IDs{splitString(front, ';')};
-        
-        while (!IDs.empty())
+        std::vector<int> IDs{};
+        for (const auto& ID : splitString(front, ';')) 
+        { 
+            IDs.push_back(makeInt(ID)); 
+        }
+
+        if (batch::isOpen())
+        {
+            batch::m_deletedIDs.insert(batch::m_deletedIDs.end(), IDs.begin()
+                , IDs.end());
+            return;
+        }
+
+        for (const int ID : WORLD.deleteBalls(IDs))
         {
-            int ID{makeInt(dequeue(IDs))};
-
-            auto& ballList{WORLD.getBallsModifiable()};
-            
-            try
-            {
-            ballList.erase(std::find(ballList.begin(), ballList.end()
-                , WORLD.getBallByID(ID)));
-            WINDOW.setTime({});
-            PHYS.purgeKeyframes(WINDOW.getTime());
-            }
-            catch (WorldException ex)
-            {
             Debug::err("Ball with ID " + std::to_string(ID) + " not found");
-            }
         }
+
+        // one purge for all of them
+        const Time time{WINDOW.getTime()};
+        WINDOW.setTime({});
+        PHYS.purgeKeyframes(time);
     }
     else { throw CommandException::WrongArgument; }
 }
 void InputHandler::balls::clear()
 {
-    WORLD.getBallsModifiable().clear();
+    // whatever was staged before would be cleared anyway
+    batch::m_newBalls.clear();
+    batch::m_deletedIDs.clear();
+    WORLD.clearBalls();
 }
 
 void InputHandler::view::parse(COMMAND& command)
@@ -392,6 +524,8 @@ void InputHandler::view::parse(COMMAND& command)
 
     if      (front == "zoom"     || front == "z") { zoom::parse    (command); }
     else if (front == "position" || front == "p") { position::parse(command); }
+    else if (front == "atlas"    || front == "a") { atlas   ::parse(command); }
+    else if (front == "framerate"|| front == "f") { framerate::parse(command); }
     else { throw CommandException::WrongArgument; }
 }
 
@@ -435,6 +569,50 @@ void InputHandler::view::position::get()
     Debug::out(std::to_string(v.x()) + ";" + std::to_string(v.y()));
 }
 
+void InputHandler::view::atlas::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "get"   || front == "g") { get  (); }
+    else if (front == "reset" || front == "r") { reset(); }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::view::atlas::get()
+{
+    const AtlasStats stats{WINDOW.getAtlasStats()};
+    const std::size_t lookups{stats.hits + stats.misses};
+
+    string out{"hits: " + std::to_string(stats.hits)};
+    out += "; misses: " + std::to_string(stats.misses);
+    out += "; hit rate: " + (lookups == 0 ? string{"-"} 
+        : std::to_string(100.0 * static_cast<double>(stats.hits) 
+            / static_cast<double>(lookups)) + " %");
+    out += "; sprites: " + std::to_string(stats.sprites);
+    Debug::out(out);
+}
+void InputHandler::view::atlas::reset()
+{
+    WINDOW.resetAtlasStats();
+}
+
+void InputHandler::view::framerate::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "set" || front == "s") { set(command); }
+    else if (front == "get" || front == "g") { get();        }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::view::framerate::set(COMMAND& command)
+{
+    WINDOW.setFrameLimit(makeDouble(dequeue(command), 0));
+}
+void InputHandler::view::framerate::get()
+{
+    if (WINDOW.getFrameLimit() == 0) { Debug::out("unlimited"); }
+    else { Debug::out(std::to_string(WINDOW.getFrameLimit()) + " fps"); }
+}
+
 void InputHandler::bounds::parse(COMMAND& command)
 {
     string front{dequeue(command)};
@@ -512,10 +690,58 @@ void InputHandler::physics::parse(COMMAND& command)
     else if (front == "step"         || front == "s") { step::parse      (command); }
     else if (front == "iterations"   || front == "i") { iterations::parse(command); }
     else if (front == "kineticenergy"|| front == "k") { kineticEnergy    (command); }
+    else if (front == "broadphase"   || front == "b") { broadphase::parse(command); }
+    else if (front == "search"       ||front == "se") { search::parse    (command); }
+    else if (front == "mode"         || front == "m") { mode::parse      (command); }
+    else if (front == "narrowphase"  || front == "n") { narrowphase::parse(command); }
+    else if (front == "workers"      || front == "w") { workers::parse   (command); }
+    else if (front == "retention"    ||front == "re") { retention::parse (command); }
+    else if (front == "cputime"      || front == "c") { cputime::parse   (command); }
+    else if (front == "stats"        ||front == "st") { stats::parse     (command); }
     else if (front == "logkineticenergy"|| front == "l") 
         { logkineticenergy::parse(command); }
     else { throw CommandException::WrongArgument; }
 }
+void InputHandler::physics::stats::parse(COMMAND& command)
+{
+    if (command.empty()) 
+    { 
+        get();
+        return;
+    }
+    string front{dequeue(command)};
+
+    if      (front == "get"   || front == "g") { get  (); }
+    else if (front == "reset" || front == "r") { reset(); }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::physics::stats::get()
+{
+    for (const auto& line : Profiler::getReport()) { Debug::out(line); }
+}
+void InputHandler::physics::stats::reset()
+{
+    Profiler::reset();
+}
+void InputHandler::physics::cputime::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "get"   || front == "g") { get  (); }
+    else if (front == "reset" || front == "r") { reset(); }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::physics::cputime::get()
+{
+    Debug::out(std::to_string(PHYS.getCPUTimePerSimulatedSecond()) 
+        + " cpu s per simulated s (" + std::to_string(PHYS.getCPUTime()) 
+        + " cpu s over " + std::to_string(PHYS.getSimulatedTime().getS()) 
+        + " simulated s)");
+}
+void InputHandler::physics::cputime::reset()
+{
+    PHYS.resetCPUTime();
+}
 void InputHandler::physics::time(COMMAND& command)
 {
     outTime(PHYS.getSimulationTime(), command);
@@ -595,12 +821,237 @@ void InputHandler::physics::iterations::set(COMMAND& command)
     PHYS.setMaxCollisionIterations(makeInt(dequeue(command), 0));
 }
 
+void InputHandler::physics::broadphase::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "get" || front == "g") { get();        }
+    else if (front == "set" || front == "s") { set(command); }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::physics::broadphase::get()
+{
+    switch (PHYS.getBroadPhase())
+    {
+    case BroadPhase::BruteForce:
+        Debug::out("bruteforce");
+        break;
+    case BroadPhase::Grid:
+        Debug::out("grid");
+        break;
+    }
+}
+void InputHandler::physics::broadphase::set(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "bruteforce" || front == "b") 
+        { PHYS.setBroadPhase(BroadPhase::BruteForce); }
+    else if (front == "grid"       || front == "g") 
+        { PHYS.setBroadPhase(BroadPhase::Grid);       }
+    else { throw CommandException::WrongParameter; }
+}
+
+void InputHandler::physics::narrowphase::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "get" || front == "g") { get();        }
+    else if (front == "set" || front == "s") { set(command); }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::physics::narrowphase::get()
+{
+    switch (PHYS.getNarrowPhase())
+    {
+    case Collision::Kernel::Scalar:
+        Debug::out("scalar");
+        break;
+    case Collision::Kernel::SSE2:
+        Debug::out("sse2");
+        break;
+    case Collision::Kernel::AVX2:
+        Debug::out("avx2");
+        break;
+    }
+}
+void InputHandler::physics::narrowphase::set(COMMAND& command)
+{
+    string front{dequeue(command)};
+    Collision::Kernel kernel{};
+
+    if      (front == "scalar" || front == "s") 
+        { kernel = Collision::Kernel::Scalar;         }
+    else if (front == "sse2")
+        { kernel = Collision::Kernel::SSE2;           }
+    else if (front == "avx2")
+        { kernel = Collision::Kernel::AVX2;           }
+    else if (front == "auto"   || front == "a")
+        { kernel = Collision::getBestKernel();        }
+    else { throw CommandException::WrongParameter; }
+
+    if (!Collision::isSupported(kernel))
+    {
+        Debug::err("This CPU does not support " + front 
+            + ", using scalar kernel instead.");
+    }
+    PHYS.setNarrowPhase(kernel);
+}
+
+void InputHandler::physics::workers::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "get" || front == "g") { get();        }
+    else if (front == "set" || front == "s") { set(command); }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::physics::workers::get()
+{
+    Debug::out(std::to_string(PHYS.getWorkerCount()));
+}
+void InputHandler::physics::workers::set(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    // 0 or auto picks one worker per hardware thread
+    if (front == "auto" || front == "a") { front = "0"; }
+    int workers{makeInt(front, 0)};
+    if (workers == 0)
+    {
+        workers = std::max(1, static_cast<int>(
+            std::thread::hardware_concurrency()));
+    }
+
+    PHYS.setWorkerCount(static_cast<std::size_t>(workers));
+}
+
+void InputHandler::physics::retention::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "get" || front == "g") { get();        }
+    else if (front == "set" || front == "s") { set(command); }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::physics::retention::get()
+{
+    const auto& retention{WORLD.getKeyframeRetention()};
+
+    string out{"age: "};
+    out += retention.maxAge 
+        ? std::to_string(retention.maxAge->getS()) + " s" : "unlimited";
+    out += " keyframes: ";
+    out += retention.maxKeyframes 
+        ? std::to_string(*retention.maxKeyframes) : "unlimited";
+    out += " memory: ";
+    out += retention.memoryBudget 
+        ? std::to_string(*retention.memoryBudget / million) + " MB" 
+        : "unlimited";
+    out += " (currently " + std::to_string(WORLD.getKeyframeCount()) 
+        + " keyframes, " + std::to_string(WORLD.getKeyframeCount() 
+        * sizeof(Keyframe) / million) + " MB)";
+
+    Debug::out(out);
+}
+void InputHandler::physics::retention::set(COMMAND& command)
+{
+    // limits that aren't given are removed
+    KeyframeRetention retention{};
+
+    while (!command.empty())
+    {
+        string param{dequeue(command)};
+
+        if      (unprefix(param, "age=")       || unprefix(param, "a="))
+            { retention.maxAge = makeTime(param); }
+        else if (unprefix(param, "keyframes=") || unprefix(param, "k="))
+            { retention.maxKeyframes 
+                = static_cast<std::size_t>(makeInt(param, 1)); }
+        else if (unprefix(param, "memory=")    || unprefix(param, "m="))
+            { retention.memoryBudget 
+                = static_cast<std::size_t>(makeDouble(param, 0) * million); }
+        else if (param == "unlimited" || param == "u") {}
+        else { throw CommandException::WrongParameter; }
+    }
+
+    WORLD.setKeyframeRetention(retention);
+}
+
+void InputHandler::physics::mode::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "get" || front == "g") { get();        }
+    else if (front == "set" || front == "s") { set(command); }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::physics::mode::get()
+{
+    switch (PHYS.getSimulationMode())
+    {
+    case SimulationMode::Timestep:
+        Debug::out("timestep");
+        break;
+    case SimulationMode::EventDriven:
+        Debug::out("event");
+        break;
+    }
+}
+void InputHandler::physics::mode::set(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "timestep" || front == "t") 
+        { PHYS.setSimulationMode(SimulationMode::Timestep);    }
+    else if (front == "event"    || front == "e") 
+        { PHYS.setSimulationMode(SimulationMode::EventDriven); }
+    else { throw CommandException::WrongParameter; }
+}
+
+void InputHandler::physics::search::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "get" || front == "g") { get(); }
+    else if (PHYS.isLoggingKineticEnergy())
+    {
+        Debug::err("Cannot use commands that alter world state while logging"
+            " kinetic energy.");
+    }
+    else if (front == "set" || front == "s") { set(command); }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::physics::search::get()
+{
+    switch (PHYS.getCollisionSearch())
+    {
+    case CollisionSearch::Bisection:
+        Debug::out("bisection");
+        break;
+    case CollisionSearch::Analytic:
+        Debug::out("analytic");
+        break;
+    }
+}
+void InputHandler::physics::search::set(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "bisection" || front == "b") 
+        { PHYS.setCollisionSearch(CollisionSearch::Bisection); }
+    else if (front == "analytic"  || front == "a") 
+        { PHYS.setCollisionSearch(CollisionSearch::Analytic);  }
+    else { throw CommandException::WrongParameter; }
+}
+
 void InputHandler::physics::logkineticenergy::parse(COMMAND& command)
 {
     string front{dequeue(command)};
 
     if      (front == "begin" || front == "b") { logkineticenergy::begin(command); }
     else if (front == "end"   || front == "e") { logkineticenergy::end();   }
+    else if (front == "get"   || front == "g") { logkineticenergy::get();   }
     else { throw CommandException::WrongArgument; }
 }
 void InputHandler::physics::logkineticenergy::begin(COMMAND& command)
@@ -614,6 +1065,7 @@ void InputHandler::physics::logkineticenergy::begin(COMMAND& command)
     string filename{};
     Time interval{};
     std::deque<string> tags;
+    LogOverflow overflow{LogOverflow::Block};
 
     while (!command.empty())
     {
@@ -624,7 +1076,15 @@ void InputHandler::physics::logkineticenergy::begin(COMMAND& command)
         else if (unprefix(param, "interval=") || unprefix(param, "i="))
             { interval = makeTime(param); }
         else if (unprefix(param, "tags=") || unprefix(param, "t="))
-            { tags = Ball::getTagsFromString(param); }
+            { tags = splitString(param, ';'); }
+        else if (unprefix(param, "overflow=") || unprefix(param, "o="))
+        {
+            if      (param == "block" || param == "b") 
+                { overflow = LogOverflow::Block; }
+            else if (param == "drop"  || param == "d") 
+                { overflow = LogOverflow::Drop; }
+            else { throw CommandException::WrongParameter; }
+        }
     }
 
     if (filename.empty() || interval == Time{})
@@ -633,7 +1093,7 @@ void InputHandler::physics::logkineticenergy::begin(COMMAND& command)
         return;
     }
 
-    PHYS.beginLoggingKineticEnergy(filename, interval, tags);
+    PHYS.beginLoggingKineticEnergy(filename, interval, tags, overflow);
 }
 void InputHandler::physics::logkineticenergy::end()
 {
@@ -645,9 +1105,29 @@ void InputHandler::physics::logkineticenergy::end()
 
     PHYS.stopLoggingKineticEnergy();
 }
+void InputHandler::physics::logkineticenergy::get()
+{
+    const auto& logger{PHYS.getLogger()};
+
+    string out{PHYS.isLoggingKineticEnergy() ? "logging" : "not logging"};
+    out += "; overflow: ";
+    out += logger.getOverflow() == LogOverflow::Block ? "block" : "drop";
+    out += "; written: " + std::to_string(logger.getWrittenCount());
+    out += "; dropped: " + std::to_string(logger.getDroppedCount());
+    Debug::out(out);
+}
 
 string InputHandler::load::fileBeingLoaded{};
 
+void InputHandler::loadFile(const std::string& filename)
+{
+    // goes straight to the load command, since parseInput would lowercase
+    // the file name
+    COMMAND command{};
+    command.push("file=" + filename);
+    load::parse(command);
+}
+
 void InputHandler::load::parse(COMMAND& command)
 {
     string front{dequeue(command)};
@@ -687,20 +1167,179 @@ void InputHandler::load::parse(COMMAND& command)
     fileBeingLoaded.clear();
 }
 
+void InputHandler::batch::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "begin"  || front == "b") { begin ();       }
+    else if (front == "commit" || front == "c") { commit(command); }
+    else if (front == "abort"  || front == "a") { abort ();       }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::batch::begin()
+{
+    if (m_open) 
+    { 
+        Debug::err("A batch is already open.");
+        return;
+    }
+
+    m_open = true;
+    m_time = WINDOW.getTime();
+}
+void InputHandler::batch::commit(COMMAND& command)
+{
+    if (!m_open) 
+    { 
+        Debug::err("There is no open batch to commit.");
+        return;
+    }
+
+    bool report{false};
+    if (!command.empty())
+    {
+        string front{dequeue(command)};
+
+        if (front == "report" || front == "r") { report = true; }
+        else { throw CommandException::WrongArgument; }
+    }
+
+    // closed first, so that the batch doesn't stay open if anything throws
+    m_open = false;
+    std::vector<BallSpec> newBalls{std::move(m_newBalls)};
+    std::vector<int> deletedIDs{std::move(m_deletedIDs)};
+    m_newBalls.clear();
+    m_deletedIDs.clear();
+
+    // checked before anything is changed, so that the batch is applied as a
+    // whole or not at all
+    if (const Time historyStart{WORLD.getHistoryStart()}; m_time < historyStart)
+    {
+        Debug::err("The batch was begun at " + std::to_string(m_time.getS())
+            + " s, which is no longer in history. The earliest time available"
+            " is " + std::to_string(historyStart.getS()) + " s, see physics"
+            " retention. Nothing was changed.");
+        return;
+    }
+
+    double oldTimescale{WINDOW.getTimescale()};
+    WINDOW.setTimescale(0);
+    Time oldRunahead{PHYS.getRunaheadTime()};
+    PHYS.setRunaheadTime({});
+
+    for (const int ID : WORLD.deleteBalls(deletedIDs))
+    {
+        Debug::err("Ball with ID " + std::to_string(ID) + " not found");
+    }
+
+    const std::vector<BallRejection> rejected{WORLD.newBalls(newBalls, m_time)};
+
+    WINDOW.setTime({});
+    PHYS.purgeKeyframes(m_time);
+
+    WINDOW.setTimescale(oldTimescale);
+    PHYS.setRunaheadTime(oldRunahead);
+
+    if (report)
+    {
+        for (const auto& r : rejected)
+        {
+            const BallSpec& b{newBalls[r.spec]};
+            string position{std::to_string(b.position.x()) + ";"
+                + std::to_string(b.position.y())};
+
+            Debug::err("Ball " + std::to_string(r.spec + 1) + " at " + position
+                + (r.overlaps ? " overlaps the ball with ID " 
+                    + std::to_string(*r.overlaps) 
+                : string{" is outside the world bounds"}) + ".");
+        }
+    }
+    else if (!rejected.empty())
+    {
+        Debug::err(std::to_string(rejected.size()) + " balls were in an invalid"
+            " position, such as inside another ball or outside the world bounds."
+            " Use 'batch commit report' to list them.");
+    }
+}
+void InputHandler::batch::abort()
+{
+    if (!m_open) 
+    { 
+        Debug::err("There is no open batch to abort.");
+        return;
+    }
+
+    m_open = false;
+    m_newBalls.clear();
+    m_deletedIDs.clear();
+}
+
+void InputHandler::trace::parse(COMMAND& command)
+{
+    string front{dequeue(command)};
+
+    if      (front == "begin" || front == "b") { begin();       }
+    else if (front == "end"   || front == "e") { end(command);  }
+    else { throw CommandException::WrongArgument; }
+}
+void InputHandler::trace::begin()
+{
+    Tracer::begin();
+}
+void InputHandler::trace::end(COMMAND& command)
+{
+    string filename{"trace.json"};
+    if (!command.empty()) { filename = dequeue(command); }
+
+    Tracer::end();
+    const auto written{Tracer::write(filename)};
+    if (!written)
+    {
+        Debug::err("Couldn't open " + filename);
+        return;
+    }
+
+    Debug::out("Wrote " + std::to_string(*written) + " spans to " + filename);
+    if (const std::size_t dropped{Tracer::getDroppedCount()}; dropped > 0)
+    {
+        Debug::err(std::to_string(dropped) + " spans didn't fit into the"
+            " buffers and were dropped.");
+    }
+}
+
 void InputHandler::wait::parse(COMMAND& command)
 {
     string front{dequeue(command)};
 
     if (unprefix(front, "time=") || unprefix(front, "t="))
     {
-        m_time.push_back({makeTime(front), command});
+        const Time time{makeTime(front)};
+        m_time.push({time, m_queued++, command});
     }
     else if (unprefix(front, "physicstime=") || unprefix(front, "p="))
     {
-        m_phys.push_back({makeTime(front), command});
+        const Time time{makeTime(front)};
+        m_phys.push({time, m_queued++, command});
     }
     else { throw CommandException::WrongArgument; }
 }
+std::vector<COMMAND> InputHandler::wait::takeDue(Time physicsTime
+    , Time windowTime)
+{
+    std::vector<COMMAND> due{};
+    takeDue(m_phys, physicsTime, due);
+    takeDue(m_time, windowTime, due);
+    return due;
+}
+void InputHandler::wait::takeDue(Queue& queue, Time time
+    , std::vector<COMMAND>& due)
+{
+    while (!queue.empty() && queue.top().time <= time)
+    {
+        due.push_back(queue.top().command);
+        queue.pop();
+    }
+}
 
 string makeLowercase(string str)
 {
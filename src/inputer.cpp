@@ -1,28 +1,49 @@
 #include "inputer.hpp"
+#include "trace.hpp"
 
-Inputer::State Inputer::m_state{State::Sleeping};
-std::string Inputer::m_inputString{""};
+std::array<std::string, Inputer::m_capacity> Inputer::m_lines{};
+std::atomic<std::size_t> Inputer::m_head{0};
+std::atomic<std::size_t> Inputer::m_taken{0};
+std::size_t Inputer::m_tail{0};
+std::atomic<bool> Inputer::m_started{false};
+std::function<void()> Inputer::m_onInput{};
 
-bool Inputer::beginInput()
+void Inputer::start(std::function<void()> onInput)
 {
-    if (m_state != State::Sleeping)
-    {
-        return false;
-    }
-    m_state = State::Reading;
-    std::thread TgetInput{readInput};
-    TgetInput.detach();
-    return true;
+    if (m_started.exchange(true)) { return; }
+
+    m_onInput = std::move(onInput);
+    // blocks in getline until the program ends, so it can't be joined
+    std::thread{readInput}.detach();
 }
 
 std::string Inputer::getInput()
 {
-    m_state = State::Sleeping;
-    return m_inputString;
+    std::string line{std::move(m_lines[m_tail % m_capacity])};
+    m_tail++;
+    // release hands the slot back to the reader
+    m_taken.store(m_tail, std::memory_order_release);
+    return line;
 }
 
 void Inputer::readInput()
 {
-    std::getline(std::cin, m_inputString);
-    m_state = State::HasInput;
-}
\ No newline at end of file
+    Tracer::setThreadName("input");
+
+    std::string line{};
+    std::size_t head{0};
+    while (std::getline(std::cin, line))
+    {
+        TraceSpan span{"queue line"};
+        while (head - m_taken.load(std::memory_order_acquire) >= m_capacity)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds{100});
+        }
+
+        m_lines[head % m_capacity] = std::move(line);
+        head++;
+        // release publishes the line to the consumer
+        m_head.store(head, std::memory_order_release);
+        if (m_onInput) { m_onInput(); }
+    }
+}
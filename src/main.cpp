@@ -13,6 +13,8 @@ int main()
     Physiker physiker{state, world, currentTime};
 
     InputHandler::init(world, window, physiker, state);
+    // physics sleeps while it's ahead, every frame may give it work again
+    window.setOnFrame([&physiker] { physiker.wake(); });
 
     std::thread TphysicsUpdate(&Physiker::loop, &physiker);
 
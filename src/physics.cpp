@@ -7,6 +7,14 @@ public:
     static void checkWaiting();
 };
 
+// time after start by the given number of seconds, rounded up so that balls
+// are touching (or very slightly overlapping) when a collision is handled
+Time roundUpToNS(Time start, double seconds)
+{
+    return start 
+        + Time::makeNS(static_cast<int64_t>(std::ceil(seconds * billion)));
+}
+
 bool operator== (const BallPair& a, const BallPair& b)
 {
     if (a.getFirst() == b.getFirst() && a.getSecond() == b.getSecond())
@@ -27,81 +35,129 @@ Physiker::Physiker(AppState& state, World& world, const Time& currentTime
     , m_maxCollisionIterations{maxCollisionIterations}
     , m_simulationTime{}
     , m_runahead{Time::makeS(100)}
-    , m_logStream{}
+    , m_endTime{}
+    , m_readsTerminal{true}
+    , m_publishesSnapshots{true}
+    , m_snapshotTime{}
+    , m_nextSnapshot{}
+    , m_wakeMutex{}
+    , m_wakeSignal{}
+    , m_woken{false}
+    , m_cpuStart{std::clock()}
+    , m_simulatedTime{}
+    , m_stepCount{0}
+    , m_ballCollisionCount{0}
+    , m_wallCollisionCount{0}
+    , m_broadPhase{BroadPhase::Grid}
+    , m_grid{}
+    , m_positions{}
+    , m_narrowPhaseKernel{Collision::getBestKernel()}
+    , m_narrowPhase{Collision::getNarrowPhase(m_narrowPhaseKernel)}
+    , m_collisionSearch{CollisionSearch::Analytic}
+    , m_workers{1}
+    , m_workerBuffers(1)
+    , m_tilePairs{}
+    , m_tileBoundPairs{}
+    , m_tileEarliest{}
+    , m_mode{SimulationMode::Timestep}
+    , m_events{}
+    , m_eventsOutdated{true}
+    , m_eventHorizon{}
+    , m_eventMaxSpeed{}
+    , m_eventBallCount{}
+    , m_nextRetentionCheck{}
+    , m_logger{}
     , m_isLogging{false}
     , m_nextLogTime{}
     , m_logInterval{}
     , m_logTags{}
-    , m_sep{';'}
+    , m_logSample{}
     , m_state{state}
     , m_world{world}
     , m_currentTime{currentTime}
 {}
 
+void Physiker::setNarrowPhase(Collision::Kernel kernel)
+{
+    if (!Collision::isSupported(kernel)) { kernel = Collision::Kernel::Scalar; }
+
+    m_narrowPhaseKernel = kernel;
+    m_narrowPhase = Collision::getNarrowPhase(kernel);
+}
+
+void Physiker::setWorkerCount(std::size_t workers)
+{
+    m_workers.setWorkerCount(workers);
+    m_workerBuffers.resize(m_workers.getWorkerCount());
+}
+
 double Physiker::getKineticEnergy(Time time, std::string_view tag)
 {
-    const auto balls{m_world.getBallsWithTag(tag)};
+    // nothing changes after the end time, so the running sums are exact
+    if (time >= m_world.endTime) 
+    { 
+        return m_world.getCurrentKineticEnergy(tag); 
+    }
+
+    const auto& balls{m_world.getBalls()};
 
     double r{};
-    for (const Ball& b : balls)
+    m_world.forEachBallWithTag(tag, [&](std::size_t i)
     {
-        r += b.getKineticEnergy(time);
-    }
+        r += balls[i].getKineticEnergy(time, KeyframeCursor::Physics);
+    });
 
     return r;
 }
 
 void Physiker::beginLoggingKineticEnergy(const std::string& filename, Time interval
-    , const std::deque<std::string>& logTags)
+    , const std::deque<std::string>& logTags, LogOverflow overflow)
 {
-    if (m_logStream.is_open()) { return; }
+    if (m_logger.isOpen()) { return; }
     
-    if (fileExists(filename + ".csv"))
+    std::string path{filename + ".csv"};
+    if (fileExists(path))
     {
         int i{1};
         while (fileExists(filename + "_" + std::to_string(i)  + ".csv"))
         {
             i++;
         }
-        m_logStream.open(filename + "_" + std::to_string(i) + ".csv");
+        path = filename + "_" + std::to_string(i) + ".csv";
+    }
+
+    std::vector<std::string> columns{"Time:"};
+    for (const auto& tag : logTags) { columns.push_back(tag + ":"); }
+    if (!m_logger.open(path, columns, overflow))
+    {
+        Debug::err("Couldn't open " + path + " for logging.");
+        return;
     }
-    else { m_logStream.open(filename + ".csv"); }
 
     m_isLogging = true;
     purgeKeyframes(m_currentTime);
     m_nextLogTime = m_simulationTime;
     m_logInterval = interval;
     m_logTags = logTags;
-
-    writeValToLog("Time:");
-    for (const auto& tag : m_logTags)
-    {
-        writeValToLog(tag + ":");
-    }
-    m_logStream << "\n";
+    m_logSample.resize(columns.size());
 }
 void Physiker::stopLoggingKineticEnergy()
 {
-    if (!m_logStream.is_open()) { return; }
+    if (!m_logger.isOpen()) { return; }
 
     m_isLogging = false;
     m_nextLogTime = {};
     m_logTags.clear();
-    m_logStream.close();
+    m_logger.close();
 }
 void Physiker::logKineticEnergy()
 {
-    writeValToLog(std::to_string(m_simulationTime.getS()));
-    
-    for (const auto& tag : m_logTags)
+    m_logSample[0] = m_simulationTime.getS();
+    for (std::size_t i{0}; i < m_logTags.size(); i++)
     {
-        writeValToLog(std::to_string(getKineticEnergy(m_simulationTime, tag)));
+        m_logSample[i + 1] = getKineticEnergy(m_simulationTime, m_logTags[i]);
     }
-    m_logStream << "\n";
-}
-void Physiker::writeValToLog(std::string_view value)
-{
-    m_logStream << value << m_sep;
+    m_logger.push(m_logSample);
 }
 bool Physiker::fileExists(const std::string& name)
 {
@@ -115,185 +171,575 @@ bool Physiker::fileExists(const std::string& name)
 
 void Physiker::purgeKeyframes(Time purgeTime)
 {
-    for (auto& b : m_world.getBallsModifiable())
-    {
-        Keyframe replacement{b.getPositionAtTime(purgeTime)
-            , b.getLastKeyframeBeforeTime(purgeTime).velocity, {}};
-        b.purgeKeyframes(replacement);
-    }
+    m_world.purgeKeyframes(purgeTime);
     
     m_simulationTime = {};
+    m_nextRetentionCheck = {};
+    m_eventsOutdated = true;
 }
 
 void Physiker::loop()
 {
+    Tracer::setThreadName("physics");
+    if (m_readsTerminal) { Inputer::start([this] { wake(); }); }
+
     while (m_state == AppState::simulation)
     {
-        InputHandler::checkWaiting();
-        Inputer::beginInput();
-        if (Inputer::hasInput())
+        if (m_endTime && m_simulationTime >= *m_endTime) { return; }
+
+        handleInput();
+
+        if (m_currentTime != m_snapshotTime 
+            && std::chrono::steady_clock::now() >= m_nextSnapshot)
         {
-            InputHandler::parseInput(Inputer::getInput());
+            publishSnapshot();
         }
 
-        if (m_simulationTime > m_currentTime + m_runahead) { continue; }
+        // event driven steps stop exactly at the limit instead of going past
+        // it, and can't get any further from there
+        const Time ahead{m_currentTime + m_runahead};
+        if (m_simulationTime > ahead || (m_mode == SimulationMode::EventDriven
+            && m_simulationTime >= ahead))
+        {
+            // the timeout keeps snapshots coming and notices quitting even
+            // if nobody calls wake()
+            TraceSpan span{"waiting for window"};
+            std::unique_lock lock{m_wakeMutex};
+            m_wakeSignal.wait_for(lock, m_snapshotInterval
+                , [this] { return m_woken; });
+            m_woken = false;
+            continue; 
+        }
+
+        step();
+    }
+}
+
+void Physiker::handleInput()
+{
+    ProfileScope profile{Phase::Input};
+
+    InputHandler::checkWaiting();
+    // everything read since the last step, so piped input goes as fast as
+    // the commands can run
+    while (m_readsTerminal && Inputer::hasInput()
+        && m_state == AppState::simulation)
+    {
+        InputHandler::parseInput(Inputer::getInput());
+    }
+}
+
+void Physiker::wake()
+{
+    {
+        std::lock_guard lock{m_wakeMutex};
+        m_woken = true;
+    }
+    m_wakeSignal.notify_one();
+}
+
+double Physiker::getCPUTime()
+{
+    return static_cast<double>(std::clock() - m_cpuStart) / CLOCKS_PER_SEC;
+}
+
+double Physiker::getCPUTimePerSimulatedSecond()
+{
+    const double simulated{m_simulatedTime.getS()};
+    return simulated > 0 ? getCPUTime() / simulated : 0;
+}
+
+void Physiker::resetCPUTime()
+{
+    m_cpuStart = std::clock();
+    m_simulatedTime = {};
+}
+
+void Physiker::publishSnapshot()
+{
+    if (!m_publishesSnapshots) { return; }
+
+    ProfileScope profile{Phase::Snapshot};
+    auto& snapshot{m_world.snapshots.beginWrite()};
+    const auto& balls{m_world.getBalls()};
+    // the window keeps changing its time while this runs
+    m_snapshotTime = m_currentTime;
+    m_nextSnapshot = std::chrono::steady_clock::now() + m_snapshotInterval;
+
+    snapshot.resize(balls.size());
+    snapshot.bounds = m_world.getWorldBounds();
+    snapshot.inaccessibleBefore = std::nullopt;
+
+    const auto fill{[&](Time time)
+    {
+        snapshot.time = time;
+        for (std::size_t i{0}; i < balls.size(); i++)
+        {
+            const auto& b{balls[i]};
+            const auto& k{b.getLastKeyframeBeforeTime(time
+                , KeyframeCursor::Renderer)};
+
+            snapshot.positionX[i] = k.startPosition.x();
+            snapshot.positionY[i] = k.startPosition.y();
+            snapshot.velocityX[i] = k.velocity.x();
+            snapshot.velocityY[i] = k.velocity.y();
+            snapshot.segmentStart[i] = k.keyframeTime;
+            // the last segment goes on until physics adds a keyframe, which
+            // can only happen after the end time the window stops at
+            snapshot.segmentEnd[i] = b.getNextKeyframeTime(k).value_or(
+                Time::makeNS(std::numeric_limits<int64_t>::max()));
+            snapshot.radius[i] = b.getRadius();
+            snapshot.color[i] = b.getColor();
+        }
+    }};
+
+    try { fill(m_snapshotTime); }
+    catch (WorldException ex)
+    {
+        if (ex != WorldException::TimeInaccessible) { throw; }
+        // keyframes for the window time were evicted, the window moves
+        // itself to the earliest time that can still be shown
+        snapshot.inaccessibleBefore = m_world.getHistoryStart();
+        fill(*snapshot.inaccessibleBefore);
+    }
+
+    m_world.snapshots.publish();
+}
+
+void Physiker::step()
+{
+    ProfileScope profile{Phase::Step};
+    const Time stepStart{m_simulationTime};
+
+    if (m_mode == SimulationMode::EventDriven)
+    {
+        stepEvents();
+    }
+    else
+    {
         m_simulationTime += m_timestep;
 
         findCollisionTime();
 
         handleBoundsCollisions();
         handleBallCollisions();
+    }
 
-        m_world.endTime = m_simulationTime;
+    m_world.endTime = m_simulationTime;
+    m_simulatedTime += m_simulationTime - stepStart;
+    m_stepCount++;
 
-        if (m_isLogging && m_simulationTime >= m_nextLogTime)
-        {
-            logKineticEnergy();
-            m_nextLogTime += m_logInterval;
-        }
+    if (m_simulationTime >= m_nextRetentionCheck)
+    {
+        ProfileScope retention{Phase::Retention};
+        m_world.enforceKeyframeRetention(m_simulationTime, m_currentTime);
+        m_nextRetentionCheck = m_simulationTime 
+            + Time::makeMS(m_retentionIntervalMS);
+    }
+
+    if (m_isLogging && m_simulationTime >= m_nextLogTime)
+    {
+        ProfileScope logging{Phase::Logging};
+        logKineticEnergy();
+        m_nextLogTime += m_logInterval;
     }
 }
 
 void Physiker::handleBoundsCollisions()
 {
+    ProfileScope profile{Phase::BoundsCollisions};
     for (auto& colpair : getOutOfBoundsBalls(true))
     {
-        //b.get().newKeyframe({{0, 0}, {0, 0}, m_simulationTime});
-        auto& b{colpair.getBall()};
-        auto& ballPos{b.getPositionAtTime(m_simulationTime)};
-        auto& ballVel
-            { b.getLastKeyframeBeforeTime(m_simulationTime).velocity };
-        
-        Keyframe keyframe{ballPos, ballVel, m_simulationTime};
-        if (getOutOfBoundsBalls(true).size() > 1)
-        {
-            //keyframe.startPosition = {0, 0};
-            //keyframe.velocity = {0, 0};
-            //Debug::log("multiple balls colliding with bounds");
-        }
-        switch (colpair.getDir())
-        {
-        case Direction::right:
-            keyframe.velocity = {-abs(ballVel.x()), ballVel.y()};
-            break;
-        case Direction::left:
-            keyframe.velocity = {abs(ballVel.x()), ballVel.y()};
-            break;
-        case Direction::up:
-            keyframe.velocity = {ballVel.x(), abs(ballVel.y())};
-            break;
-        case Direction::down:
-            keyframe.velocity = {ballVel.x(), -abs(ballVel.y())};
-            break;
-        default:
-            Debug::err("something has gone terribly wrong in the code for"
-                " collisions with bounds");
-            break;
-        }
-        b.newKeyframe(keyframe);
+        resolveBoundsCollision(colpair.getBall(), colpair.getDir());
     }
 }
 
+void Physiker::resolveBoundsCollision(std::size_t b, Direction dir)
+{
+    //b.get().newKeyframe({{0, 0}, {0, 0}, m_simulationTime});
+    const auto& hot{m_world.getHotState()};
+    auto ballPos{hot.getPosition(b, m_simulationTime)};
+    auto ballVel{hot.getVelocity(b)};
+    
+    Keyframe keyframe{ballPos, ballVel, m_simulationTime};
+    switch (dir)
+    {
+    case Direction::right:
+        keyframe.velocity = {-abs(ballVel.x()), ballVel.y()};
+        break;
+    case Direction::left:
+        keyframe.velocity = {abs(ballVel.x()), ballVel.y()};
+        break;
+    case Direction::up:
+        keyframe.velocity = {ballVel.x(), abs(ballVel.y())};
+        break;
+    case Direction::down:
+        keyframe.velocity = {ballVel.x(), -abs(ballVel.y())};
+        break;
+    default:
+        Debug::err("something has gone terribly wrong in the code for"
+            " collisions with bounds");
+        break;
+    }
+    m_world.newKeyframe(b, keyframe);
+    m_wallCollisionCount++;
+}
+
 void Physiker::handleBallCollisions()
 {
+    ProfileScope profile{Phase::BallCollisions};
     auto list{getCollidingBalls(true)};
     for (auto& colpair : list.get())
     {
-        Debug::log("balls collided");
+        resolveBallCollision(colpair.getFirst(), colpair.getSecond());
+    }
+}
+
+bool Physiker::resolveBallCollision(std::size_t ballA, std::size_t ballB)
+{
+    Debug::log("balls collided");
 
-        using Eigen::Vector2d;
-        using Eigen::Rotation2Dd;
+    using Eigen::Vector2d;
+    using Eigen::Rotation2Dd;
 
-        Ball& ballA{colpair.getFirst()};
-        Ball& ballB{colpair.getSecond()};
+    const auto& hot{m_world.getHotState()};
 
-        // coords flipped because in sdl2 positive y is down
+    // coords flipped because in sdl2 positive y is down
 
-        // ball centers unflipped
-        const Vector2d& Oauf {ballA.getPositionAtTime(m_simulationTime)};
-        const Vector2d& Obuf {ballB.getPositionAtTime(m_simulationTime)};
+    // ball centers unflipped
+    const Vector2d Oauf {hot.getPosition(ballA, m_simulationTime)};
+    const Vector2d Obuf {hot.getPosition(ballB, m_simulationTime)};
 
-        // ball centers
-        const Vector2d Oa {flipVector2d(Oauf, Axis::Y)};
-        const Vector2d Ob {flipVector2d(Obuf, Axis::Y)};
+    // ball centers
+    const Vector2d Oa {flipVector2d(Oauf, Axis::Y)};
+    const Vector2d Ob {flipVector2d(Obuf, Axis::Y)};
 
-        // velocity vectors before collision (unflipped)
-        const Vector2d& Vauf
-            {ballA.getLastKeyframeBeforeTime(m_simulationTime).velocity};
-        const Vector2d& Vbuf
-            {ballB.getLastKeyframeBeforeTime(m_simulationTime).velocity};
+    // velocity vectors before collision (unflipped)
+    const Vector2d Vauf{hot.getVelocity(ballA)};
+    const Vector2d Vbuf{hot.getVelocity(ballB)};
 
-        // velocity vectors before collision (flipped)
-        const Vector2d Va{flipVector2d(Vauf, Axis::Y)};
-        const Vector2d Vb{flipVector2d(Vbuf, Axis::Y)};
-        
-        // ball masses
-        const double& Ma{ballA.getMass()};
-        const double& Mb{ballB.getMass()};
-
-        // direction from one ball center to another
-        const Vector2d dir{Oa - Ob};
-        //angle of the line joining the centers of both balls
-        Rotation2Dd prpndclr{atan2(dir.y(), dir.x())};
-        if (prpndclr.smallestAngle() > PI/2) { prpndclr.angle() -= PI; }
-        if (prpndclr.smallestAngle() < -PI/2) { prpndclr.angle() += PI; }
-
-        // rotated velocity vectors before collision
-        const Vector2d rotVa{prpndclr.inverse() * Va};
-        const Vector2d rotVb{prpndclr.inverse() * Vb};
-
-        // rotated ball centers
-        Vector2d rotOa{prpndclr.inverse() * Oa};
-        Vector2d rotOb{prpndclr.inverse() * Ob};
-
-        const int centerDiffSign{sign(rotOa.y() - rotOb.y())};
-        // so that balls which are flying in opposite directions don't collide
-        if (centerDiffSign == sign(rotVa.y() - rotVb.y()))
+    // velocity vectors before collision (flipped)
+    const Vector2d Va{flipVector2d(Vauf, Axis::Y)};
+    const Vector2d Vb{flipVector2d(Vbuf, Axis::Y)};
+    
+    // ball masses
+    const double Ma{hot.mass[ballA]};
+    const double Mb{hot.mass[ballB]};
+
+    // direction from one ball center to another
+    const Vector2d dir{Oa - Ob};
+    //angle of the line joining the centers of both balls
+    Rotation2Dd prpndclr{atan2(dir.y(), dir.x())};
+    if (prpndclr.smallestAngle() > PI/2) { prpndclr.angle() -= PI; }
+    if (prpndclr.smallestAngle() < -PI/2) { prpndclr.angle() += PI; }
+
+    // rotated velocity vectors before collision
+    const Vector2d rotVa{prpndclr.inverse() * Va};
+    const Vector2d rotVb{prpndclr.inverse() * Vb};
+
+    // rotated ball centers
+    Vector2d rotOa{prpndclr.inverse() * Oa};
+    Vector2d rotOb{prpndclr.inverse() * Ob};
+
+    // after rotating, the line joining the centers is the x axis
+    const int centerDiffSign{sign(rotOa.x() - rotOb.x())};
+    // so that balls which are flying in opposite directions don't collide
+    if (centerDiffSign == sign(rotVa.x() - rotVb.x()))
+    {
+        return false;
+    }
+
+    // this is done to correct the slight overlap between the balls
+    const double Ra{hot.radius[ballA]};
+    const double Rb{hot.radius[ballB]};
+
+    const double overlap{abs(rotOa.x() - rotOb.x()) - (Ra + Rb)};
+    const double correction{overlap / 2 * centerDiffSign};
+    
+    rotOa = {rotOa.x() - correction, rotOa.y()};
+    rotOb = {rotOb.x() + correction, rotOb.y()};
+
+    const Vector2d Oa2{prpndclr * rotOa};
+    const Vector2d Ob2{prpndclr * rotOb};
+    //if (rotOa.x() - rotOb.x());
+
+    // rotatated velocity vectors after collision
+    const Vector2d rotVa2
+    {
+        ((Ma - Mb) * rotVa.x() + 2 * Mb * rotVb.x()) / (Ma + Mb)
+        , rotVa.y()
+    };
+    const Vector2d rotVb2
+    {
+        rotVa2.x() + rotVa.x() - rotVb.x()
+        , rotVb.y()
+    };
+
+    // velocity vectors after collision
+    const Vector2d Va2{prpndclr * rotVa2};
+    const Vector2d Vb2{prpndclr * rotVb2};
+
+    Debug::log("kinetic energy after collision: "
+        + std::to_string((Ma * pow(Va2.norm(), 2) + Mb * pow(Vb2.norm(), 2)) / 2));
+
+    m_world.newKeyframe(ballA, {flipVector2d(Oa2, Axis::Y)
+        , flipVector2d(Va2, Axis::Y), m_simulationTime});
+    m_world.newKeyframe(ballB, {flipVector2d(Ob2, Axis::Y)
+        , flipVector2d(Vb2, Axis::Y), m_simulationTime});
+    m_ballCollisionCount++;
+
+    return true;
+}
+
+void Physiker::stepEvents()
+{
+    const auto& hot{m_world.getHotState()};
+
+    if (m_eventsOutdated || hot.size() != m_eventBallCount 
+        || m_simulationTime >= m_eventHorizon)
+    {
+        predictAllEvents();
+    }
+
+    Time limit{std::min(m_eventHorizon, m_currentTime + m_runahead)};
+    if (m_isLogging) { limit = std::min(limit, m_nextLogTime); }
+    if (m_endTime) { limit = std::min(limit, *m_endTime); }
+    limit = std::max(limit, m_simulationTime);
+
+    const auto event{m_events.peek(hot)};
+    if (!event || event->time > limit)
+    {
+        m_simulationTime = limit;
+        return;
+    }
+    m_events.pop();
+    m_simulationTime = event->time;
+
+    if (event->wall != Direction::none)
+    {
+        resolveBoundsCollision(event->ballA, event->wall);
+    }
+    else if (!resolveBallCollision(event->ballA, event->ballB)) { return; }
+
+    // a ball got faster than the broad phase allows for, so predictions for
+    // it could miss collisions
+    for (const auto b : {event->ballA, event->ballB})
+    {
+        if (hot.getVelocity(b).norm() > m_eventMaxSpeed)
         {
+            m_eventHorizon = m_simulationTime;
             return;
         }
+    }
 
-        // this is done to correct the slight overlap between the balls
-        const double Ra{ballA.getRadius()};
-        const double Rb{ballB.getRadius()};
+    predictEvents(event->ballA);
+    if (event->wall == Direction::none)
+    {
+        predictEvents(event->ballB, event->ballA);
+    }
+}
 
-        const double overlap{abs(rotOa.y() - rotOb.y()) - (Ra + Rb)};
-        const double correction{overlap / 2 * centerDiffSign};
-        
-        rotOa = {rotOa.x(), rotOa.y() + correction};
-        rotOb = {rotOb.x(), rotOb.y() - correction};
+void Physiker::predictAllEvents()
+{
+    ProfileScope profile{Phase::EventPrediction};
+    const auto& hot{m_world.getHotState()};
+
+    m_events.clear();
+    m_eventsOutdated = false;
+    m_eventBallCount = hot.size();
+
+    double maxRadius{0};
+    m_eventMaxSpeed = 0;
+    for (std::size_t i{0}; i < hot.size(); i++)
+    {
+        maxRadius = std::max(maxRadius, hot.radius[i]);
+        m_eventMaxSpeed = std::max(m_eventMaxSpeed, hot.getVelocity(i).norm());
+    }
+
+    // the horizon is chosen so that no ball can travel further than about
+    // its radius before events are predicted again, which keeps the broad
+    // phase cells small
+    Time horizonLength{m_runahead};
+    if (m_eventMaxSpeed > 0)
+    {
+        horizonLength = std::max(m_timestep, Time::makeS(
+            (maxRadius + collisionErrorMarginHeuristic) / m_eventMaxSpeed));
+    }
+    m_eventHorizon = m_simulationTime + horizonLength;
+
+    // balls can approach each other by at most twice the highest speed
+    updateBroadPhase(m_simulationTime, 2 * m_eventMaxSpeed 
+        * horizonLength.getS() + collisionErrorMarginHeuristic);
+
+    std::uint64_t tested{0};
+    std::uint64_t pairsHit{0};
+    forEachCandidatePair([&](std::size_t a, std::size_t b)
+    {
+        tested++;
+        if (predictBallEvent(a, b)) { pairsHit++; }
+    });
+    Profiler::add(Counter::PairsTested, tested);
+    Profiler::add(Counter::PairsHit, pairsHit);
+    for (std::size_t i{0}; i < hot.size(); i++)
+    {
+        predictWallEvent(i);
+    }
+}
+
+void Physiker::predictEvents(std::size_t ball, std::optional<std::size_t> skip)
+{
+    std::uint64_t tested{0};
+    std::uint64_t pairsHit{0};
+    auto predict{[&](std::size_t other)
+    {
+        if (other == skip) { return; }
+        tested++;
+        if (predictBallEvent(ball, other)) { pairsHit++; }
+    }};
+
+    // the broad phase was built at the start of the horizon with a margin
+    // that covers all movement until its end, so neighbours from back then
+    // are still the only balls this one can reach
+    forEachCandidateOf(ball, predict);
+    Profiler::add(Counter::PairsTested, tested);
+    Profiler::add(Counter::PairsHit, pairsHit);
+
+    predictWallEvent(ball);
+}
+
+bool Physiker::predictBallEvent(std::size_t ballA, std::size_t ballB)
+{
+    const auto& hot{m_world.getHotState()};
+
+    auto t{Collision::ballBallTime(
+        hot.getPosition(ballB, m_simulationTime) 
+            - hot.getPosition(ballA, m_simulationTime)
+        , hot.getVelocity(ballB) - hot.getVelocity(ballA)
+        , hot.radius[ballA] + hot.radius[ballB])};
+    if (!t) { return false; }
+
+    const Time time{roundUpToNS(m_simulationTime, *t)};
+    if (time > m_eventHorizon) { return false; }
+
+    m_events.push({time, ballA, ballB, Direction::none
+        , hot.revision[ballA], hot.revision[ballB]});
+    return true;
+}
+
+void Physiker::predictWallEvent(std::size_t ball)
+{
+    if (!m_world.getWorldBounds()) { return; }
+
+    const auto& hot{m_world.getHotState()};
+
+    auto hit{Collision::ballWallTime(hot.getPosition(ball, m_simulationTime)
+        , hot.getVelocity(ball)
+        , m_world.getWorldBounds()->growBy(-hot.radius[ball]))};
+    if (!hit) { return; }
+
+    const Time time{roundUpToNS(m_simulationTime, hit->first)};
+    if (time > m_eventHorizon) { return; }
+
+    m_events.push({time, ball, ball, hit->second
+        , hot.revision[ball], hot.revision[ball]});
+}
+
+void Physiker::findCollisionTime()
+{
+    ProfileScope profile{Phase::CollisionTime};
+    switch (m_collisionSearch)
+    {
+    case CollisionSearch::Bisection:
+        findCollisionTimeBisection();
+        break;
+    case CollisionSearch::Analytic:
+        findCollisionTimeAnalytic();
+        break;
+    }
+}
+
+void Physiker::findCollisionTimeAnalytic()
+{
+    using Eigen::Vector2d;
+
+    const auto& hot{m_world.getHotState()};
+    if (hot.size() == 0) { return; }
+
+    const Time stepStart{m_simulationTime - m_timestep};
+    const double stepLength{m_timestep.getS()};
 
-        const Vector2d Oa2{prpndclr * rotOa};
-        const Vector2d Ob2{prpndclr * rotOb};
-        //if (rotOa.x() - rotOb.x());
+    double maxSpeedSquare{0};
+    for (std::size_t i{0}; i < hot.size(); i++)
+    {
+        maxSpeedSquare = std::max(maxSpeedSquare
+            , hot.velocityX[i] * hot.velocityX[i] 
+            + hot.velocityY[i] * hot.velocityY[i]);
+    }
+    const double maxSpeed{std::sqrt(maxSpeedSquare)};
+
+    // two balls can approach each other by at most twice the highest speed
+    const auto& positions{updateBroadPhase(stepStart
+        , 2 * maxSpeed * stepLength + collisionErrorMarginHeuristic)};
 
-        // rotatated velocity vectors after collision
-        const Vector2d rotVa2
+    const auto& bounds{m_world.getWorldBounds()};
+    const std::size_t tiles{getTileCount()};
+    m_tileEarliest.assign(tiles, std::nullopt);
+
+    m_workers.run(tiles, [&](std::size_t tile, std::size_t)
+    {
+        // seconds after stepStart at which the first collision in the tile
+        // happens
+        std::optional<double> earliest{};
+        std::uint64_t tested{0};
+        std::uint64_t pairsHit{0};
+
+        forEachCandidatePairInTile(tile, tiles, [&](std::size_t a, std::size_t b)
         {
-            ((Ma - Mb) * rotVa.x() + 2 * Mb * rotVb.x()) / (Ma + Mb)
-            , rotVa.y()
-        };
-        const Vector2d rotVb2
+            auto t{Collision::ballBallTime(positions[b] - positions[a]
+                , hot.getVelocity(b) - hot.getVelocity(a)
+                , hot.radius[a] + hot.radius[b])};
+
+            tested++;
+            if (t && *t <= stepLength) { pairsHit++; }
+            if (t && *t <= stepLength && (!earliest || *t < *earliest)) 
+                { earliest = t; }
+        });
+        Profiler::add(Counter::PairsTested, tested);
+        Profiler::add(Counter::PairsHit, pairsHit);
+
+        if (bounds)
         {
-            rotVa2.x() + rotVa.x() - rotVb.x()
-            , rotVb.y()
-        };
+            forEachBallInTile(tile, tiles, [&](std::size_t i)
+            {
+                auto wallHit{Collision::ballWallTime(positions[i]
+                    , hot.getVelocity(i), bounds->growBy(-hot.radius[i]))};
 
-        // velocity vectors after collision
-        const Vector2d Va2{prpndclr * rotVa2};
-        const Vector2d Vb2{prpndclr * rotVb2};
+                if (wallHit && wallHit->first <= stepLength
+                    && (!earliest || wallHit->first < *earliest)) 
+                    { earliest = wallHit->first; }
+            });
+        }
 
-        Debug::log("kinetic energy after collision: "
-            + std::to_string((Ma * pow(Va2.norm(), 2) + Mb * pow(Vb2.norm(), 2)) / 2));
+        m_tileEarliest[tile] = earliest;
+    });
 
-        ballA.newKeyframe({flipVector2d(Oa2, Axis::Y), flipVector2d(Va2, Axis::Y)
-            , m_simulationTime});
-        ballB.newKeyframe({flipVector2d(Ob2, Axis::Y), flipVector2d(Vb2, Axis::Y)
-            , m_simulationTime});
+    std::optional<double> earliest{};
+    for (const auto& t : m_tileEarliest)
+    {
+        if (t && (!earliest || *t < *earliest)) { earliest = t; }
     }
+
+    if (!earliest) { return; }
+
+    Time impact{roundUpToNS(stepStart, *earliest)};
+
+    // makes sure that time actually moves forward
+    if (impact <= stepStart) { impact = stepStart + Time::makeNS(1); }
+
+    if (impact < m_simulationTime) { m_simulationTime = impact; }
 }
 
-void Physiker::findCollisionTime()
+void Physiker::findCollisionTimeBisection()
 {
     if(getOutOfBoundsBalls(false).empty() 
         && getCollidingBalls(false).get().empty())
@@ -360,49 +806,189 @@ void Physiker::findCollisionTime()
 
         lastAction = currentAction;
     }
+    Profiler::add(Counter::BisectionIterations, static_cast<std::uint64_t>(
+        std::min(i + 1, m_maxCollisionIterations)));
 }
 
 BallPairVector Physiker::getCollidingBalls(bool getTouching)
 {
+    const auto& hot{m_world.getHotState()};
+
+    const auto& positions
+        {updateBroadPhase(m_simulationTime, collisionErrorMarginHeuristic)};
+
+    const double touchMargin{getTouching ? m_collisionErrMargin : 0};
+
+    const std::size_t tiles{getTileCount()};
+    if (m_tilePairs.size() < tiles) { m_tilePairs.resize(tiles); }
+
+    m_workers.run(tiles, [&](std::size_t tile, std::size_t worker)
+    {
+        auto& buffers{m_workerBuffers[worker]};
+        auto& pairs{m_tilePairs[tile]};
+        pairs.clear();
+        std::uint64_t tested{0};
+
+        forEachBallInTile(tile, tiles, [&](std::size_t a)
+        {
+            buffers.candidateX.clear();
+            buffers.candidateY.clear();
+            buffers.candidateRadius.clear();
+            buffers.candidateIndex.clear();
+
+            // every pair is only tested once, by the ball with the lower index
+            forEachCandidateOf(a, [&](std::size_t b)
+            {
+                if (b < a) { return; }
+
+                buffers.candidateX.push_back(positions[b].x());
+                buffers.candidateY.push_back(positions[b].y());
+                buffers.candidateRadius.push_back(hot.radius[b]);
+                buffers.candidateIndex.push_back(b);
+            });
+
+            buffers.hits.resize(buffers.candidateIndex.size());
+            const std::size_t hitCount{m_narrowPhase(positions[a].x()
+                , positions[a].y(), hot.radius[a], buffers.candidateX.data()
+                , buffers.candidateY.data(), buffers.candidateRadius.data()
+                , buffers.candidateIndex.size(), touchMargin
+                , buffers.hits.data())};
+
+            tested += buffers.candidateIndex.size();
+            for (std::size_t i{0}; i < hitCount; i++)
+            {
+                pairs.push_back({a, buffers.candidateIndex[buffers.hits[i]]});
+            }
+        });
+        Profiler::add(Counter::PairsTested, tested);
+        Profiler::add(Counter::PairsHit, pairs.size());
+    });
+
     std::vector<BallPair> result;
-    auto& balls = m_world.getBallsModifiable();
+    for (std::size_t tile{0}; tile < tiles; tile++)
+    {
+        result.insert(result.end(), m_tilePairs[tile].begin()
+            , m_tilePairs[tile].end());
+    }
 
-    for (auto& ba : balls){
-        
-    Eigen::Vector2d aPos{ba.getPositionAtTime(m_simulationTime)};
-    double aRad{ba.getRadius()};
+    // grid tiles aren't in ball order, so pairs are sorted to make the order
+    // collisions are handled in independent of tiling and worker count
+    std::sort(result.begin(), result.end()
+        , [](const BallPair& a, const BallPair& b)
+        {
+            return std::pair{a.getFirst(), a.getSecond()}
+                < std::pair{b.getFirst(), b.getSecond()};
+        });
+
+    return result;
+}
+
+const std::vector<Eigen::Vector2d>& Physiker::updateBroadPhase(Time time
+    , double margin)
+{
+    ProfileScope profile{Phase::BroadPhase};
+    const auto& hot{m_world.getHotState()};
 
-    for (auto& bb : balls)
+    if (m_broadPhase == BroadPhase::Grid)
     {
-        if (bb == ba) { continue; }
-        
-        Eigen::Vector2d bPos{bb.getPositionAtTime(m_simulationTime)};
-        double bRad{bb.getRadius()};
-        
-        double radSum{bRad + aRad + collisionErrorMarginHeuristic};
-        
-        // preliminary filter to reduce amount of math
-        if (abs(aPos.x() - bPos.x()) > radSum 
-         || abs(aPos.y() - bPos.y()) > radSum) { continue; }
+        m_grid.update(hot, m_world.getWorldBounds(), time, margin);
+        return m_grid.getPositions();
+    }
 
-        // not knowing linear algebra, the fact that norm() returns the absolute
-        // value of a vector and not the normalized form of a vector severely
-        // fucked me over
-        double distanceSquare{((aPos - bPos).squaredNorm())};
-        double collisionDistance{aRad + bRad};
+    m_positions.resize(hot.size());
+    for (std::size_t i{0}; i < hot.size(); i++)
+    {
+        m_positions[i] = hot.getPosition(i, time);
+    }
+    return m_positions;
+}
 
-        if (getTouching) 
-            { collisionDistance += std::max(bRad, aRad) * m_collisionErrMargin; }
+template <typename F>
+void Physiker::forEachCandidatePair(F&& func)
+{
+    if (m_broadPhase == BroadPhase::Grid)
+    {
+        m_grid.forEachCandidatePair(func);
+        return;
+    }
 
-        double collisionDistanceSquare{collisionDistance * collisionDistance};
-        
-        if (distanceSquare <= collisionDistanceSquare)
+    for (std::size_t a{0}; a < m_positions.size(); a++)
+    {
+        for (std::size_t b{a + 1}; b < m_positions.size(); b++)
         {
-            result.push_back({ba, bb});
+            func(a, b);
         }
-    }}
+    }
+}
 
-    return result;
+template <typename F>
+void Physiker::forEachCandidateOf(std::size_t a, F&& func)
+{
+    if (m_broadPhase == BroadPhase::Grid)
+    {
+        m_grid.forEachNeighbour(a, func);
+        return;
+    }
+
+    for (std::size_t b{0}; b < m_positions.size(); b++)
+    {
+        if (b != a) { func(b); }
+    }
+}
+
+std::size_t Physiker::getTileCount()
+{
+    const std::size_t wanted{m_workers.getWorkerCount() * m_tilesPerWorker};
+    const std::size_t available{m_broadPhase == BroadPhase::Grid
+        ? static_cast<std::size_t>(m_grid.getRows()) : m_positions.size()};
+
+    return std::max<std::size_t>(1, std::min(wanted, available));
+}
+
+std::pair<std::size_t, std::size_t> Physiker::getTileRange(std::size_t tile
+    , std::size_t tileCount, std::size_t count)
+{
+    return {count * tile / tileCount, count * (tile + 1) / tileCount};
+}
+
+template <typename F>
+void Physiker::forEachBallInTile(std::size_t tile, std::size_t tileCount
+    , F&& func)
+{
+    if (m_broadPhase == BroadPhase::Grid)
+    {
+        const auto [first, end]{getTileRange(tile, tileCount
+            , static_cast<std::size_t>(m_grid.getRows()))};
+        m_grid.forEachBallInRows(static_cast<int>(first)
+            , static_cast<int>(end), func);
+        return;
+    }
+
+    const auto [first, end]{getTileRange(tile, tileCount, m_positions.size())};
+    for (std::size_t a{first}; a < end; a++) { func(a); }
+}
+
+template <typename F>
+void Physiker::forEachCandidatePairInTile(std::size_t tile
+    , std::size_t tileCount, F&& func)
+{
+    if (m_broadPhase == BroadPhase::Grid)
+    {
+        const auto [first, end]{getTileRange(tile, tileCount
+            , static_cast<std::size_t>(m_grid.getRows()))};
+        m_grid.forEachCandidatePairInRows(static_cast<int>(first)
+            , static_cast<int>(end), func);
+        return;
+    }
+
+    const auto [first, end]{getTileRange(tile, tileCount, m_positions.size())};
+    for (std::size_t a{first}; a < end; a++)
+    {
+        for (std::size_t b{a + 1}; b < m_positions.size(); b++)
+        {
+            func(a, b);
+        }
+    }
 }
 
 std::vector<BoundBallPair> Physiker::getOutOfBoundsBalls(bool getTouching)
@@ -412,43 +998,56 @@ std::vector<BoundBallPair> Physiker::getOutOfBoundsBalls(bool getTouching)
     {
         return result;
     }
-    for (auto& b : m_world.getBallsModifiable())
-    {
-        // effective radius of ball
-        double rad {getTouching 
-            ? b.getRadius() + b.getRadius() * m_collisionErrMargin
-            : b.getRadius()};
+    const auto& hot{m_world.getHotState()};
+    const Rect bounds{m_world.getWorldBounds().value()};
 
-        // this is the area in which the *center* of the ball can exist
-        Rect collisionBounds
-            { m_world.getWorldBounds().value().growBy(-rad)};
-        
-        Eigen::Vector2d pos{ b.getPositionAtTime(m_simulationTime) };
+    // no broad phase needed here, so balls are simply split by index
+    const std::size_t tiles{std::max<std::size_t>(1, std::min(hot.size()
+        , m_workers.getWorkerCount() * m_tilesPerWorker))};
+    if (m_tileBoundPairs.size() < tiles) { m_tileBoundPairs.resize(tiles); }
+
+    m_workers.run(tiles, [&](std::size_t tile, std::size_t)
+    {
+        auto& pairs{m_tileBoundPairs[tile]};
+        pairs.clear();
 
-        // if ball not out of bounds, skip it
-        if (collisionBounds.contains(pos))
+        const auto [first, end]{getTileRange(tile, tiles, hot.size())};
+        for (std::size_t b{first}; b < end; b++)
         {
-           continue;
-        }
+            // effective radius of ball
+            double rad {getTouching 
+                ? hot.radius[b] + hot.radius[b] * m_collisionErrMargin
+                : hot.radius[b]};
 
-        /*printf("ball out of bounds at coords %.*e", DECIMAL_DIG
-            , b.getPositionAtTime(m_simulationTime).x());
-        printf("; %.*e", DECIMAL_DIG
-            , b.getPositionAtTime(m_simulationTime).y());
-        printf(" with radius %.*e\n", DECIMAL_DIG, rad);
-        fflush(stdout);*/
+            // this is the area in which the *center* of the ball can exist
+            Rect collisionBounds{bounds.growBy(-rad)};
+            
+            Eigen::Vector2d pos{ hot.getPosition(b, m_simulationTime) };
 
-        Direction dir{};
+            // if ball not out of bounds, skip it
+            if (collisionBounds.contains(pos))
+            {
+               continue;
+            }
 
-        // last check is unnecessary, but makes errors easier to catch
-        if      (pos.x() >= collisionBounds.getRight()) { dir = Direction::right;}
-        else if (pos.x() <= collisionBounds.getLeft())  { dir = Direction::left; }
-        else if (pos.y() <= collisionBounds.getTop())   { dir = Direction::up;   }
-        else if (pos.y() >= collisionBounds.getBottom()){ dir = Direction::down; }
-        
-        BoundBallPair collisionPair{b, dir};
-        
-        result.push_back(collisionPair);
+            Direction dir{};
+
+            // last check is unnecessary, but makes errors easier to catch
+            if      (pos.x() >= collisionBounds.getRight()) { dir = Direction::right;}
+            else if (pos.x() <= collisionBounds.getLeft())  { dir = Direction::left; }
+            else if (pos.y() <= collisionBounds.getTop())   { dir = Direction::up;   }
+            else if (pos.y() >= collisionBounds.getBottom()){ dir = Direction::down; }
+            
+            pairs.push_back({b, dir});
+        }
+    });
+
+    // tiles are ranges of indices, so merging them in order keeps the result
+    // sorted by ball
+    for (std::size_t tile{0}; tile < tiles; tile++)
+    {
+        result.insert(result.end(), m_tileBoundPairs[tile].begin()
+            , m_tileBoundPairs[tile].end());
     }
     return result;
-}
\ No newline at end of file
+}
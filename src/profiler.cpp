@@ -0,0 +1,151 @@
+#include "profiler.hpp"
+
+std::mutex Profiler::m_mutex{};
+std::vector<std::unique_ptr<Profiler::ThreadStats>> Profiler::m_threads{};
+std::atomic<std::uint64_t> Profiler::m_epoch{0};
+
+Profiler::ThreadStats& Profiler::getThreadStats()
+{
+    thread_local ThreadStats* stats{nullptr};
+    if (stats == nullptr)
+    {
+        std::lock_guard lock{m_mutex};
+        m_threads.push_back(std::make_unique<ThreadStats>());
+        stats = m_threads.back().get();
+        stats->epoch = m_epoch.load();
+    }
+
+    const std::uint64_t epoch{m_epoch.load(std::memory_order_relaxed)};
+    if (stats->epoch.load(std::memory_order_relaxed) != epoch)
+    {
+        for (auto& v : stats->calls)    { v.store(0, std::memory_order_relaxed); }
+        for (auto& v : stats->totalNS)  { v.store(0, std::memory_order_relaxed); }
+        for (auto& v : stats->maxNS)    { v.store(0, std::memory_order_relaxed); }
+        for (auto& v : stats->counters) { v.store(0, std::memory_order_relaxed); }
+        stats->epoch.store(epoch, std::memory_order_relaxed);
+    }
+    return *stats;
+}
+
+void Profiler::addTime(Phase phase, std::chrono::nanoseconds time)
+{
+    auto& stats{getThreadStats()};
+    const auto i{static_cast<std::size_t>(phase)};
+    const auto ns{static_cast<std::uint64_t>(std::max<std::int64_t>(0
+        , time.count()))};
+
+    bump(stats.calls[i], 1);
+    bump(stats.totalNS[i], ns);
+    if (ns > stats.maxNS[i].load(std::memory_order_relaxed))
+    {
+        stats.maxNS[i].store(ns, std::memory_order_relaxed);
+    }
+}
+
+void Profiler::add(Counter counter, std::uint64_t amount)
+{
+    bump(getThreadStats().counters[static_cast<std::size_t>(counter)], amount);
+}
+
+ProfileStats Profiler::get()
+{
+    ProfileStats result{};
+    const std::uint64_t epoch{m_epoch.load()};
+
+    std::lock_guard lock{m_mutex};
+    for (const auto& t : m_threads)
+    {
+        // blocks from before the last reset that haven't been cleared yet
+        if (t->epoch.load(std::memory_order_relaxed) != epoch) { continue; }
+
+        for (std::size_t i{0}; i < result.phases.size(); i++)
+        {
+            auto& p{result.phases[i]};
+            p.calls += t->calls[i].load(std::memory_order_relaxed);
+            p.total += std::chrono::nanoseconds{static_cast<std::int64_t>(
+                t->totalNS[i].load(std::memory_order_relaxed))};
+            p.max = std::max(p.max, std::chrono::nanoseconds{
+                static_cast<std::int64_t>(t->maxNS[i].load(
+                    std::memory_order_relaxed))});
+        }
+        for (std::size_t i{0}; i < result.counters.size(); i++)
+        {
+            result.counters[i] += t->counters[i].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+void Profiler::reset()
+{
+    m_epoch++;
+}
+
+std::vector<std::string> Profiler::getReport()
+{
+    const ProfileStats stats{get()};
+    std::vector<std::string> lines{};
+
+    const auto ms{[](std::chrono::nanoseconds t)
+        { return std::to_string(static_cast<double>(t.count()) / 1e6); }};
+    const auto us{[](double ns) { return std::to_string(ns / 1000); }};
+
+    for (std::size_t i{0}; i < stats.phases.size(); i++)
+    {
+        const auto& p{stats.phases[i]};
+        const double mean{p.calls == 0 ? 0
+            : static_cast<double>(p.total.count()) / static_cast<double>(p.calls)};
+
+        lines.push_back(std::string{getName(static_cast<Phase>(i))} + ": "
+            + std::to_string(p.calls) + " calls, " + ms(p.total) + " ms total, "
+            + us(mean) + " us mean, "
+            + us(static_cast<double>(p.max.count())) + " us max");
+    }
+
+    const auto steps{stats[Phase::Step].calls};
+    const auto tested{stats[Counter::PairsTested]};
+    const auto hit{stats[Counter::PairsHit]};
+    lines.push_back(std::string{getName(Counter::BisectionIterations)} + ": "
+        + std::to_string(stats[Counter::BisectionIterations]) + " ("
+        + std::to_string(steps == 0 ? 0
+            : static_cast<double>(stats[Counter::BisectionIterations])
+                / static_cast<double>(steps)) + " per step)");
+    lines.push_back(std::string{getName(Counter::PairsTested)} + ": "
+        + std::to_string(tested));
+    lines.push_back(std::string{getName(Counter::PairsHit)} + ": "
+        + std::to_string(hit) + " (" + std::to_string(tested == 0 ? 0
+            : 100.0 * static_cast<double>(hit) / static_cast<double>(tested))
+        + " %)");
+    return lines;
+}
+
+std::string_view Profiler::getName(Phase phase)
+{
+    switch (phase)
+    {
+    case Phase::Step:             return "step";
+    case Phase::BroadPhase:       return "broad phase";
+    case Phase::CollisionTime:    return "collision time";
+    case Phase::BoundsCollisions: return "bounds collisions";
+    case Phase::BallCollisions:   return "ball collisions";
+    case Phase::EventPrediction:  return "event prediction";
+    case Phase::Retention:        return "retention";
+    case Phase::Logging:          return "logging";
+    case Phase::Input:            return "input";
+    case Phase::Snapshot:         return "snapshot";
+    case Phase::count:            break;
+    }
+    return "";
+}
+
+std::string_view Profiler::getName(Counter counter)
+{
+    switch (counter)
+    {
+    case Counter::BisectionIterations: return "bisection iterations";
+    case Counter::PairsTested:         return "pairs tested";
+    case Counter::PairsHit:            return "pairs hit";
+    case Counter::count:               break;
+    }
+    return "";
+}
@@ -0,0 +1,133 @@
+#include "sample_logger.hpp"
+#include "trace.hpp"
+#include <charconv>
+
+SampleLogger::SampleLogger()
+    : m_stream{}
+    , m_thread{}
+    , m_overflow{LogOverflow::Block}
+    , m_ring{}
+    , m_width{0}
+    , m_head{0}
+    , m_tail{0}
+    , m_stopping{false}
+    , m_written{0}
+    , m_dropped{0}
+{}
+
+bool SampleLogger::open(const std::string& filename
+    , const std::vector<std::string>& columns, LogOverflow overflow)
+{
+    if (isOpen()) { return false; }
+
+    m_stream.open(filename);
+    if (!m_stream.is_open()) { return false; }
+
+    for (const auto& c : columns) { m_stream << c << m_sep; }
+    m_stream << "\n";
+
+    m_overflow = overflow;
+    m_width = columns.size();
+    m_ring.assign(m_capacity * m_width, 0);
+    m_head = 0;
+    m_tail = 0;
+    m_written = 0;
+    m_dropped = 0;
+    m_stopping = false;
+
+    m_thread = std::thread{&SampleLogger::writerLoop, this};
+    return true;
+}
+
+void SampleLogger::close()
+{
+    if (!isOpen()) { return; }
+
+    m_stopping = true;
+    m_thread.join();
+    m_stream.close();
+}
+
+void SampleLogger::push(std::span<const double> sample)
+{
+    const std::size_t head{m_head.load(std::memory_order_relaxed)};
+    while (head - m_tail.load(std::memory_order_acquire) >= m_capacity)
+    {
+        if (m_overflow == LogOverflow::Drop)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::this_thread::yield();
+    }
+
+    std::copy_n(sample.begin(), std::min(sample.size(), m_width)
+        , m_ring.begin() + static_cast<std::ptrdiff_t>(
+            (head % m_capacity) * m_width));
+    // release publishes the values to the writer
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+void SampleLogger::writerLoop()
+{
+    Tracer::setThreadName("logger");
+    std::string text{};
+    text.reserve(m_blockSize + 1024);
+    // longest a number printed with six decimals can get
+    char number[400];
+    // when the oldest row in text was formatted
+    std::chrono::steady_clock::time_point pendingSince{};
+
+    const auto writeText{[&]
+    {
+        TraceSpan span{"log flush"};
+        m_stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+        text.clear();
+    }};
+
+    std::size_t tail{m_tail.load(std::memory_order_relaxed)};
+    while (true)
+    {
+        const bool stopping{m_stopping};
+        const std::size_t head{m_head.load(std::memory_order_acquire)};
+
+        if (tail == head)
+        {
+            // small amounts of text wait for more, unless they have been
+            // waiting for a while. the file shouldn't lag far behind
+            if (!text.empty() && (stopping || std::chrono::steady_clock::now()
+                - pendingSince >= m_flushInterval))
+            {
+                writeText();
+                m_stream.flush();
+            }
+            if (stopping) { return; }
+            std::this_thread::sleep_for(m_idleSleep);
+            continue;
+        }
+
+        if (text.empty()) { pendingSince = std::chrono::steady_clock::now(); }
+        for (; tail != head; tail++)
+        {
+            const double* row{&m_ring[(tail % m_capacity) * m_width]};
+            for (std::size_t i{0}; i < m_width; i++)
+            {
+                // same format std::to_string used to give
+                const auto end{std::to_chars(number, number + sizeof(number)
+                    , row[i], std::chars_format::fixed, 6).ptr};
+                text.append(number, end);
+                text += m_sep;
+            }
+            text += '\n';
+            // the slot can be reused as soon as it has been formatted
+            m_tail.store(tail + 1, std::memory_order_release);
+            m_written.fetch_add(1, std::memory_order_relaxed);
+
+            if (text.size() >= m_blockSize)
+            {
+                writeText();
+                pendingSince = std::chrono::steady_clock::now();
+            }
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#include "snapshot.hpp"
+
+void WorldSnapshot::resize(std::size_t count)
+{
+    positionX.resize(count);
+    positionY.resize(count);
+    velocityX.resize(count);
+    velocityY.resize(count);
+    segmentStart.resize(count);
+    segmentEnd.resize(count);
+    radius.resize(count);
+    color.resize(count);
+}
+
+Eigen::Vector2d WorldSnapshot::getPosition(std::size_t i, Time time) const
+{
+    if      (time < segmentStart[i]) { time = segmentStart[i]; }
+    else if (time > segmentEnd[i])   { time = segmentEnd[i]; }
+
+    const double dt{(time - segmentStart[i]).getS()};
+    return {positionX[i] + velocityX[i] * dt, positionY[i] + velocityY[i] * dt};
+}
+
+void SnapshotChannel::publish()
+{
+    // release makes the filled buffer visible to whoever picks it up, acquire
+    // makes sure the reader is done with the buffer handed back
+    const std::uint8_t old{m_middle.exchange(
+        static_cast<std::uint8_t>(m_writeIndex | m_freshFlag)
+        , std::memory_order_acq_rel)};
+    m_writeIndex = old & m_indexMask;
+}
+
+const WorldSnapshot& SnapshotChannel::read()
+{
+    if ((m_middle.load(std::memory_order_relaxed) & m_freshFlag) != 0)
+    {
+        const std::uint8_t old{m_middle.exchange(m_readIndex
+            , std::memory_order_acq_rel)};
+        m_readIndex = old & m_indexMask;
+    }
+    return m_buffers[m_readIndex];
+}
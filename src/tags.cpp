@@ -0,0 +1,54 @@
+#include "tags.hpp"
+
+std::mutex TagInterner::m_mutex{};
+std::deque<std::string> TagInterner::m_names{};
+std::unordered_map<std::string_view, TagID> TagInterner::m_ids{};
+
+TagID TagInterner::intern(std::string_view name)
+{
+    std::lock_guard lock{m_mutex};
+
+    if (const auto it{m_ids.find(name)}; it != m_ids.end()) { return it->second; }
+
+    const auto id{static_cast<TagID>(m_names.size())};
+    m_names.emplace_back(name);
+    m_ids.emplace(m_names.back(), id);
+    return id;
+}
+
+std::optional<TagID> TagInterner::find(std::string_view name)
+{
+    std::lock_guard lock{m_mutex};
+
+    if (const auto it{m_ids.find(name)}; it != m_ids.end()) { return it->second; }
+    return std::nullopt;
+}
+
+const std::string& TagInterner::getName(TagID id)
+{
+    std::lock_guard lock{m_mutex};
+    return m_names.at(id);
+}
+
+void TagSet::insert(TagID id)
+{
+    if (id < 64)
+    {
+        m_bits |= std::uint64_t{1} << id;
+        return;
+    }
+
+    const std::size_t word{id / 64 - 1};
+    if (m_more.size() <= word) { m_more.resize(word + 1, 0); }
+    m_more[word] |= std::uint64_t{1} << (id % 64);
+}
+
+bool TagSet::empty() const
+{
+    if (m_bits != 0) { return false; }
+    for (const auto w : m_more)
+    {
+        if (w != 0) { return false; }
+    }
+    return true;
+}
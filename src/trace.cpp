@@ -0,0 +1,180 @@
+#include "trace.hpp"
+#include <charconv>
+#include <fstream>
+
+std::atomic<bool> Tracer::m_enabled{false};
+std::atomic<std::uint64_t> Tracer::m_epoch{0};
+const Tracer::Clock::time_point Tracer::m_origin{Tracer::Clock::now()};
+std::mutex Tracer::m_mutex{};
+std::vector<std::unique_ptr<Tracer::ThreadBuffer>> Tracer::m_threads{};
+
+namespace
+{
+// microseconds with three decimals, the unit trace events use
+void appendMicroseconds(std::string& out, std::int64_t ns)
+{
+    char number[32];
+    const auto end{std::to_chars(number, number + sizeof(number)
+        , static_cast<double>(ns) / 1000, std::chars_format::fixed, 3).ptr};
+    out.append(number, end);
+}
+
+void appendEscaped(std::string& out, std::string_view text)
+{
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) { out += ' '; }
+        else { out += c; }
+    }
+}
+}
+
+void Tracer::begin()
+{
+    m_epoch++;
+    m_enabled = true;
+}
+
+void Tracer::end()
+{
+    m_enabled = false;
+}
+
+Tracer::ThreadBuffer& Tracer::getThreadBuffer()
+{
+    thread_local ThreadBuffer* buffer{nullptr};
+    if (buffer == nullptr)
+    {
+        std::lock_guard lock{m_mutex};
+        m_threads.push_back(std::make_unique<ThreadBuffer>());
+        buffer = m_threads.back().get();
+    }
+
+    // acquire, so that a write() before the last begin() is done with the
+    // spans before they get overwritten
+    const std::uint64_t epoch{m_epoch.load(std::memory_order_acquire)};
+    if (buffer->epoch.load(std::memory_order_relaxed) != epoch)
+    {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->epoch.store(epoch, std::memory_order_release);
+    }
+    return *buffer;
+}
+
+void Tracer::setThreadName(std::string name)
+{
+    auto& buffer{getThreadBuffer()};
+
+    std::lock_guard lock{m_mutex};
+    buffer.name = std::move(name);
+}
+
+void Tracer::record(std::string_view name, Clock::time_point start
+    , Clock::time_point end, std::string_view detail)
+{
+    auto& buffer{getThreadBuffer()};
+
+    // only allocated once a thread records anything
+    if (buffer.spans.empty()) { buffer.spans.resize(m_capacity); }
+
+    const std::size_t count{buffer.count.load(std::memory_order_relaxed)};
+    if (count >= m_capacity)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& span{buffer.spans[count]};
+    span.name = name;
+    span.startNS = sinceOrigin(start);
+    span.endNS = sinceOrigin(end);
+    span.detail = detail;
+    // release publishes the span to write()
+    buffer.count.store(count + 1, std::memory_order_release);
+}
+
+std::optional<std::size_t> Tracer::write(const std::string& filename)
+{
+    std::ofstream stream{filename};
+    if (!stream.is_open()) { return std::nullopt; }
+
+    const std::uint64_t epoch{m_epoch.load()};
+    std::size_t written{0};
+    std::string out{"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"};
+    bool first{true};
+    const auto separate{[&]
+    {
+        if (!first) { out += ",\n"; }
+        first = false;
+    }};
+
+    std::lock_guard lock{m_mutex};
+    for (std::size_t t{0}; t < m_threads.size(); t++)
+    {
+        const auto& buffer{*m_threads[t]};
+        const std::string tid{std::to_string(t + 1)};
+
+        separate();
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid
+            + ",\"args\":{\"name\":\"";
+        appendEscaped(out, buffer.name.empty()
+            ? "thread " + tid : buffer.name);
+        out += "\"}}";
+
+        // buffers that haven't been used since begin() still hold old spans
+        if (buffer.epoch.load(std::memory_order_acquire) != epoch) { continue; }
+
+        const std::size_t count{buffer.count.load(std::memory_order_acquire)};
+        for (std::size_t i{0}; i < count; i++)
+        {
+            const auto& span{buffer.spans[i]};
+
+            separate();
+            out += "{\"name\":\"";
+            appendEscaped(out, span.name);
+            out += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + tid + ",\"ts\":";
+            appendMicroseconds(out, span.startNS);
+            out += ",\"dur\":";
+            appendMicroseconds(out, span.endNS - span.startNS);
+            if (!span.detail.empty())
+            {
+                out += ",\"args\":{\"detail\":\"";
+                appendEscaped(out, span.detail);
+                out += "\"}";
+            }
+            out += "}";
+            written++;
+
+            if (out.size() >= 1 << 16)
+            {
+                stream.write(out.data(), static_cast<std::streamsize>(
+                    out.size()));
+                out.clear();
+            }
+        }
+    }
+    out += "\n]}\n";
+    stream.write(out.data(), static_cast<std::streamsize>(out.size()));
+
+    return written;
+}
+
+std::size_t Tracer::getDroppedCount()
+{
+    const std::uint64_t epoch{m_epoch.load()};
+    std::size_t dropped{0};
+
+    std::lock_guard lock{m_mutex};
+    for (const auto& t : m_threads)
+    {
+        if (t->epoch.load(std::memory_order_relaxed) != epoch) { continue; }
+        dropped += t->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
@@ -1,4 +1,5 @@
 #include "window.hpp"
+#include "trace.hpp"
 
 using Eigen::Vector2d;
 
@@ -7,12 +8,27 @@ Window::Window(const AppState& state, const World& world, Time& currentTime)
     , m_windowSDL{}
     , m_surfaceSDL{}
     , m_UIfontSDL{}
+    , m_hasGeometry{false}
+    , m_circleVertices{}
+    , m_circleIndices{}
+    , m_unitCircles{}
+    , m_batchedShapes{}
+    , m_atlas{}
+    , m_atlasOutdated{false}
+    , m_spriteVertices{}
+    , m_spriteIndices{}
+    , m_batchedSprites{}
+    , m_visibleBalls{}
+    , m_heatmapCounts{}
     , m_displayScale{100}
     , m_displayCenter{540, 540}
     , m_viewOffset{0, 0}
     , m_timescale{1}
     , m_time{}
     , m_clock{}
+    , m_frameLimit{60}
+    , m_nextFrame{}
+    , m_onFrame{}
     , m_state{state}
     , m_world{world}
     , m_currentTime{currentTime}
@@ -45,6 +61,16 @@ Window::Window(const AppState& state, const World& world, Time& currentTime)
         Debug::log("Failed to load font!");
     }
 
+    // renderers without geometry support refuse even a triangle of nothing
+    const SDL_Vertex empty[3]{};
+    m_hasGeometry = SDL_RenderGeometry(m_rendererSDL, nullptr, empty, 3
+        , nullptr, 0) == 0;
+    if (!m_hasGeometry)
+    {
+        Debug::log("Renderer can't draw geometry, drawing circles line by line.");
+    }
+    m_atlas.emplace(m_rendererSDL);
+
     Debug::log("Window created.");
 }
 
@@ -71,18 +97,63 @@ void Window::drawCircle(SDL_Color color, Eigen::Vector2d position, double radius
 {
     Vector2d screenPosition = position * m_displayScale 
         + m_displayCenter + m_viewOffset * m_displayScale;
-    int screenRadius = static_cast<int>(radius * m_displayScale);
+
+    drawScreenCircle(color, static_cast<float>(screenPosition.x())
+        , static_cast<float>(screenPosition.y())
+        , static_cast<float>(radius * m_displayScale), filled);
+}
+
+void Window::drawScreenCircle(SDL_Color color, float x, float y, float radius
+    , bool filled)
+{
+    const int spriteRadius{static_cast<int>(std::lround(radius))};
+    if (filled && spriteRadius >= 1 && spriteRadius <= CircleAtlas::maxRadius
+        && drawSprite(color, x, y, spriteRadius))
+    {
+        return;
+    }
+
+    if (m_hasGeometry)
+    {
+        batchCircle(color, x, y, radius, filled);
+        return;
+    }
+    // geometry can fail halfway through a frame, what was batched before
+    // still has to go under this
+    flushGeometry();
 
     if (filled)
     {
-        screenDrawFilledCircle(color, (int)screenPosition.x()
-            , (int)screenPosition.y(), screenRadius);
+        screenDrawFilledCircle(color, (int)x, (int)y, (int)radius);
         /*screenDrawFilledRect({255, 0, 0, 255}, {(int)screenPosition.x()
             , (int)screenPosition.y(), 5, 5});*/
         return;
     }
-    screenDrawCircle(color, (int)screenPosition.x(), (int)screenPosition.y()
-        , screenRadius);
+    screenDrawCircle(color, (int)x, (int)y, (int)radius);
+}
+
+void Window::drawScreenPoint(SDL_Color color, float x, float y)
+{
+    if (m_hasGeometry)
+    {
+        batchRect(color, x - 0.5f, y - 0.5f, 1, 1);
+        return;
+    }
+    flushGeometry();
+    SDL_SetRenderDrawColor(m_rendererSDL, color.r, color.g, color.b, color.a);
+    SDL_RenderDrawPoint(m_rendererSDL, (int)x, (int)y);
+}
+
+void Window::drawScreenFilledRect(SDL_Color color, float x, float y, float w
+    , float h)
+{
+    if (m_hasGeometry)
+    {
+        batchRect(color, x, y, w, h);
+        return;
+    }
+    flushGeometry();
+    screenDrawFilledRect(color, {(int)x, (int)y, (int)w, (int)h});
 }
 
 void Window::drawRect(SDL_Color color, Rect rect, bool filled)
@@ -100,6 +171,7 @@ void Window::drawRect(SDL_Color color, Rect rect, bool filled)
 
 void Window::loop()
 {
+    Tracer::setThreadName("render");
     while (m_state == AppState::simulation)
     {
         // placeholder
@@ -119,18 +191,32 @@ void Window::loop()
             }
         }
         m_currentTime = m_time;
-
-        if (m_world.isBeingEdited) { continue; }
+        if (m_onFrame) { m_onFrame(); }
 
         redraw();
+
+        if (const double frameLimit{getFrameLimit()}; frameLimit > 0)
+        {
+            const auto now{std::chrono::steady_clock::now()};
+            m_nextFrame += std::chrono::duration_cast<
+                std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>{1 / frameLimit});
+            // don't try to catch up on frames that took too long
+            if (m_nextFrame < now) { m_nextFrame = now; }
+            TraceSpan span{"frame limit"};
+            std::this_thread::sleep_until(m_nextFrame);
+        }
     }
 }
 
 void Window::redraw()
 {
+    TraceSpan span{"redraw"};
     SDL_SetRenderDrawColor(m_rendererSDL, 255, 255, 255, 255);
     SDL_RenderClear(m_rendererSDL);
 
+    if (m_atlasOutdated.exchange(false) && m_atlas) { m_atlas->clear(); }
+
     m_clock.tick();    
     if (m_time < m_world.endTime)
     {
@@ -141,32 +227,83 @@ void Window::redraw()
 
     //std::cout << m_time.getS() << "\n";
 
-    try
-    {
-    for (const auto& b : m_world.getBalls())
+    // the latest snapshot from physics, so drawing never touches keyframes
+    // and can't be disturbed by physics changing them
+    const auto& snapshot{m_world.snapshots.read()};
+    if (snapshot.inaccessibleBefore && m_time < *snapshot.inaccessibleBefore)
     {
-        if (m_world.isBeingEdited) { continue; }
-        drawCircle(b.getColor(), b.getPositionAtTime(m_time)
-            , b.getRadius(), true);
+        m_time = *snapshot.inaccessibleBefore;
+        Debug::err("Time is inaccessible. Setting time to " 
+            + std::to_string(m_time.getS()) + " and pausing.");
+        m_timescale = 0;
     }
+
+    // balls are culled and sorted into levels of detail in screen space
+    const double width{m_displayCenter.x() * 2};
+    const double height{m_displayCenter.y() * 2};
+    const Vector2d offset{m_displayCenter + m_viewOffset * m_displayScale};
+    const auto tilesX{static_cast<std::size_t>(width) / m_heatmapTileSize + 1};
+    const auto tilesY{static_cast<std::size_t>(height) / m_heatmapTileSize + 1};
+    m_heatmapCounts.assign(tilesX * tilesY, 0);
+    m_visibleBalls.clear();
+
+    for (std::size_t i{0}; i < snapshot.size(); i++)
+    {
+        const Vector2d p{snapshot.getPosition(i, m_time) * m_displayScale 
+            + offset};
+        const double r{snapshot.radius[i] * m_displayScale};
+        if (p.x() + r < 0 || p.x() - r > width 
+            || p.y() + r < 0 || p.y() - r > height)
+        {
+            continue;
+        }
+
+        VisibleBall v{static_cast<float>(p.x()), static_cast<float>(p.y())
+            , static_cast<float>(r), i, std::nullopt};
+        // only balls that fit into a tile get merged, big ones stay circles
+        if (2 * r < m_heatmapTileSize && p.x() >= 0 && p.y() >= 0)
+        {
+            const auto tile{static_cast<std::size_t>(p.y()) / m_heatmapTileSize 
+                * tilesX + static_cast<std::size_t>(p.x()) / m_heatmapTileSize};
+            if (tile < m_heatmapCounts.size())
+            {
+                v.tile = tile;
+                m_heatmapCounts[tile]++;
+            }
+        }
+        m_visibleBalls.push_back(v);
     }
-    catch (WorldException ex)
+
+    for (const auto& v : m_visibleBalls)
     {
-        switch (ex)
+        if (v.tile && m_heatmapCounts[*v.tile] >= m_heatmapThreshold) 
         {
-        case WorldException::TimeInaccessible:
-            Debug::err("Time is inaccessible: " + std::to_string(m_time.getS())
-                + ". Setting time to 0 and pausing.");
-            m_timescale = 0;
-            m_time = Time::makeNS(1);
-            break;
-        default:
-            break;
+            continue;
+        }
+
+        if (v.radius < 0.5f) 
+        { 
+            drawScreenPoint(snapshot.color[v.ball], v.x, v.y); 
+        }
+        else 
+        { 
+            drawScreenCircle(snapshot.color[v.ball], v.x, v.y, v.radius, true);
         }
     }
+
+    for (std::size_t tile{0}; tile < m_heatmapCounts.size(); tile++)
+    {
+        if (m_heatmapCounts[tile] < m_heatmapThreshold) { continue; }
+
+        drawScreenFilledRect(getHeatmapColor(m_heatmapCounts[tile])
+            , static_cast<float>(tile % tilesX * m_heatmapTileSize)
+            , static_cast<float>(tile / tilesX * m_heatmapTileSize)
+            , m_heatmapTileSize, m_heatmapTileSize);
+    }
+    flushCircles();
     
     drawRect({0, 0, 0, 255}
-        , m_world.getWorldBounds().value_or<Rect>({0, 0, 0, 0}), false);
+        , snapshot.bounds.value_or<Rect>({0, 0, 0, 0}), false);
 
     SDL_RenderPresent(m_rendererSDL);
     // Utils::Out("redrew");
@@ -283,4 +420,237 @@ int Window::screenDrawFilledCircle(SDL_Color color, int x, int y, int radius)
     }
 
     return status;
-}
\ No newline at end of file
+}
+
+void Window::batchCircle(SDL_Color color, float x, float y, float radius
+    , bool filled)
+{
+    // enough segments that no edge strays more than half a pixel from the
+    // real circle
+    const float r{std::max(radius, 0.5f)};
+    const double segmentAngle{2 * std::acos(std::max(0.0, 1.0 - 0.5 / r))};
+    const std::size_t segments{std::clamp<std::size_t>(
+        static_cast<std::size_t>(std::ceil(2 * PI / segmentAngle)), 6, 256)};
+    const auto& unit{getUnitCircle(segments)};
+
+    // sprites batched before this have to be drawn under it
+    flushSprites();
+    const std::size_t needed{filled ? segments + 1 : segments * 2};
+    if (m_circleVertices.size() + needed > m_maxBatchVertices) 
+    {
+        flushGeometry();
+    }
+    const auto first{static_cast<int>(m_circleVertices.size())};
+    const auto n{static_cast<int>(segments)};
+    m_batchedShapes.push_back({filled ? ShapeKind::FilledCircle 
+        : ShapeKind::Circle, color, x, y, radius, radius});
+
+    if (filled)
+    {
+        // fan around the center
+        m_circleVertices.push_back({{x, y}, color, {0, 0}});
+        for (const auto& p : unit)
+        {
+            m_circleVertices.push_back({{x + p.x * r, y + p.y * r}, color, {0, 0}});
+        }
+        for (int i{0}; i < n; i++)
+        {
+            m_circleIndices.insert(m_circleIndices.end()
+                , {first, first + 1 + i, first + 1 + (i + 1) % n});
+        }
+        return;
+    }
+
+    // one pixel wide ring, inner and outer point for every segment
+    const float inner{std::max(r - 0.5f, 0.0f)};
+    const float outer{r + 0.5f};
+    for (const auto& p : unit)
+    {
+        m_circleVertices.push_back({{x + p.x * inner, y + p.y * inner}, color
+            , {0, 0}});
+        m_circleVertices.push_back({{x + p.x * outer, y + p.y * outer}, color
+            , {0, 0}});
+    }
+    for (int i{0}; i < n; i++)
+    {
+        const int a{first + 2 * i};
+        const int b{first + 2 * ((i + 1) % n)};
+        m_circleIndices.insert(m_circleIndices.end()
+            , {a, a + 1, b, b, a + 1, b + 1});
+    }
+}
+
+void Window::batchRect(SDL_Color color, float x, float y, float w, float h)
+{
+    flushSprites();
+    if (m_circleVertices.size() + 4 > m_maxBatchVertices) { flushGeometry(); }
+    const auto first{static_cast<int>(m_circleVertices.size())};
+    m_batchedShapes.push_back({ShapeKind::Rect, color, x, y, w, h});
+
+    m_circleVertices.push_back({{x,     y},     color, {0, 0}});
+    m_circleVertices.push_back({{x + w, y},     color, {0, 0}});
+    m_circleVertices.push_back({{x,     y + h}, color, {0, 0}});
+    m_circleVertices.push_back({{x + w, y + h}, color, {0, 0}});
+    m_circleIndices.insert(m_circleIndices.end()
+        , {first, first + 1, first + 2, first + 2, first + 1, first + 3});
+}
+
+bool Window::drawSprite(SDL_Color color, float x, float y, int radius)
+{
+    if (!m_atlas || !m_atlas->isAvailable()) { return false; }
+
+    auto area{m_atlas->get(radius, color)};
+    if (!area)
+    {
+        // the atlas is full. sprites already batched still point into it, so
+        // they have to be drawn before it's cleared
+        flushCircles();
+        m_atlas->clear();
+        area = m_atlas->get(radius, color);
+        if (!area) { return false; }
+    }
+
+    // sprites are aligned to whole pixels, they look blurry otherwise
+    const float left{std::round(x) - static_cast<float>(radius + 1)};
+    const float top{std::round(y) - static_cast<float>(radius + 1)};
+    const auto w{static_cast<float>(area->w)};
+    const auto h{static_cast<float>(area->h)};
+
+    const SDL_Rect destination{static_cast<int>(left), static_cast<int>(top)
+        , area->w, area->h};
+    if (!m_hasGeometry)
+    {
+        flushGeometry();
+        SDL_RenderCopy(m_rendererSDL, m_atlas->getTexture(), &*area
+            , &destination);
+        return true;
+    }
+
+    // and circles batched before this have to be drawn under the sprite
+    flushGeometry();
+    if (m_spriteVertices.size() + 4 > m_maxBatchVertices) { flushSprites(); }
+    const auto first{static_cast<int>(m_spriteVertices.size())};
+    m_batchedSprites.push_back({*area, destination});
+
+    constexpr float size{CircleAtlas::getSize()};
+    const float u0{static_cast<float>(area->x) / size};
+    const float v0{static_cast<float>(area->y) / size};
+    const float u1{u0 + w / size};
+    const float v1{v0 + h / size};
+    // the colour is already in the sprite
+    const SDL_Color white{255, 255, 255, 255};
+
+    m_spriteVertices.push_back({{left,     top},     white, {u0, v0}});
+    m_spriteVertices.push_back({{left + w, top},     white, {u1, v0}});
+    m_spriteVertices.push_back({{left,     top + h}, white, {u0, v1}});
+    m_spriteVertices.push_back({{left + w, top + h}, white, {u1, v1}});
+    m_spriteIndices.insert(m_spriteIndices.end()
+        , {first, first + 1, first + 2, first + 2, first + 1, first + 3});
+    return true;
+}
+
+AtlasStats Window::getAtlasStats() const
+{
+    if (!m_atlas) { return {}; }
+    return {m_atlas->getHits(), m_atlas->getMisses()
+        , m_atlas->getSpriteCount()};
+}
+
+void Window::resetAtlasStats()
+{
+    if (m_atlas) { m_atlas->resetStats(); }
+}
+
+void Window::flushCircles()
+{
+    flushSprites();
+    flushGeometry();
+}
+
+void Window::flushSprites()
+{
+    if (m_spriteIndices.empty()) { return; }
+
+    if (!m_hasGeometry || SDL_RenderGeometry(m_rendererSDL
+        , m_atlas->getTexture(), m_spriteVertices.data()
+        , static_cast<int>(m_spriteVertices.size()), m_spriteIndices.data()
+        , static_cast<int>(m_spriteIndices.size())) != 0)
+    {
+        disableGeometry();
+        for (const auto& [source, destination] : m_batchedSprites)
+        {
+            SDL_RenderCopy(m_rendererSDL, m_atlas->getTexture(), &source
+                , &destination);
+        }
+    }
+    m_spriteVertices.clear();
+    m_spriteIndices.clear();
+    m_batchedSprites.clear();
+}
+
+void Window::flushGeometry()
+{
+    if (m_circleIndices.empty()) { return; }
+
+    if (!m_hasGeometry || SDL_RenderGeometry(m_rendererSDL, nullptr
+        , m_circleVertices.data(), static_cast<int>(m_circleVertices.size())
+        , m_circleIndices.data(), static_cast<int>(m_circleIndices.size())) != 0)
+    {
+        disableGeometry();
+        // the batch still has to show up this frame
+        for (const auto& b : m_batchedShapes)
+        {
+            switch (b.kind)
+            {
+            case ShapeKind::FilledCircle:
+                screenDrawFilledCircle(b.color, (int)b.x, (int)b.y, (int)b.w);
+                break;
+            case ShapeKind::Circle:
+                screenDrawCircle(b.color, (int)b.x, (int)b.y, (int)b.w);
+                break;
+            case ShapeKind::Rect:
+                screenDrawFilledRect(b.color, {(int)b.x, (int)b.y, (int)b.w
+                    , (int)b.h});
+                break;
+            }
+        }
+    }
+    m_circleVertices.clear();
+    m_circleIndices.clear();
+    m_batchedShapes.clear();
+}
+
+void Window::disableGeometry()
+{
+    if (!m_hasGeometry) { return; }
+
+    Debug::err(std::string{"Drawing geometry failed, drawing circles line"
+        " by line from now on: "} + SDL_GetError());
+    m_hasGeometry = false;
+}
+
+const std::vector<SDL_FPoint>& Window::getUnitCircle(std::size_t segments)
+{
+    if (m_unitCircles.size() <= segments) { m_unitCircles.resize(segments + 1); }
+
+    auto& unit{m_unitCircles[segments]};
+    if (unit.empty())
+    {
+        for (std::size_t i{0}; i < segments; i++)
+        {
+            const double angle{2 * PI * static_cast<double>(i) 
+                / static_cast<double>(segments)};
+            unit.push_back({static_cast<float>(std::cos(angle))
+                , static_cast<float>(std::sin(angle))});
+        }
+    }
+    return unit;
+}
+
+SDL_Color Window::getHeatmapColor(std::size_t count)
+{
+    const double heat{std::clamp(std::log2(static_cast<double>(count) 
+        / m_heatmapThreshold) / 4, 0.0, 1.0)};
+    return {static_cast<Uint8>(255 * heat), 0
+        , static_cast<Uint8>(255 * (1 - heat)), 255};
+}
@@ -0,0 +1,154 @@
+#include "worker_pool.hpp"
+#include "trace.hpp"
+
+WorkerPool::WorkerPool(std::size_t workers)
+    : m_threads{}
+    , m_queues{}
+    , m_mutex{}
+    , m_wake{}
+    , m_done{}
+    , m_job{nullptr}
+    , m_batch{0}
+    , m_remaining{0}
+    , m_stopping{false}
+{
+    startThreads(workers);
+}
+
+WorkerPool::~WorkerPool()
+{
+    stopThreads();
+}
+
+void WorkerPool::setWorkerCount(std::size_t workers)
+{
+    stopThreads();
+    startThreads(workers);
+}
+
+void WorkerPool::startThreads(std::size_t workers)
+{
+    workers = std::max<std::size_t>(1, workers);
+
+    m_stopping = false;
+    for (std::size_t i{0}; i < workers; i++)
+    {
+        m_queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (std::size_t i{1}; i < workers; i++)
+    {
+        m_threads.emplace_back(&WorkerPool::work, this, i);
+    }
+}
+
+void WorkerPool::stopThreads()
+{
+    {
+        std::lock_guard lock{m_mutex};
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& t : m_threads) { t.join(); }
+    m_threads.clear();
+    m_queues.clear();
+}
+
+void WorkerPool::run(std::size_t taskCount, const Job& job)
+{
+    if (taskCount == 0) { return; }
+
+    // not worth waking anyone up
+    if (m_queues.size() == 1 || taskCount == 1)
+    {
+        for (std::size_t i{0}; i < taskCount; i++) { job(i, 0); }
+        return;
+    }
+
+    {
+        std::lock_guard lock{m_mutex};
+
+        // has to be set before any task is queued, workers that are still
+        // busy looking for tasks from the last batch can grab one right away
+        m_job = &job;
+        m_remaining = taskCount;
+        m_batch++;
+
+        // every worker starts with a contiguous block of tasks, since
+        // neighbouring tasks usually touch neighbouring memory
+        const std::size_t workers{m_queues.size()};
+        for (std::size_t w{0}; w < workers; w++)
+        {
+            std::lock_guard queueLock{m_queues[w]->mutex};
+            for (std::size_t i{taskCount * w / workers}
+                ; i < taskCount * (w + 1) / workers; i++)
+            {
+                m_queues[w]->tasks.push_back(i);
+            }
+        }
+    }
+    m_wake.notify_all();
+
+    while (runOneTask(0)) {}
+
+    std::unique_lock lock{m_mutex};
+    m_done.wait(lock, [this]{ return m_remaining == 0; });
+    m_job = nullptr;
+}
+
+void WorkerPool::work(std::size_t worker)
+{
+    Tracer::setThreadName("worker " + std::to_string(worker));
+
+    std::size_t lastBatch{0};
+    while (true)
+    {
+        {
+            std::unique_lock lock{m_mutex};
+            m_wake.wait(lock, [&]{ return m_stopping || m_batch != lastBatch; });
+            if (m_stopping) { return; }
+            lastBatch = m_batch;
+        }
+
+        TraceSpan span{"tasks"};
+        while (runOneTask(worker)) {}
+    }
+}
+
+bool WorkerPool::runOneTask(std::size_t worker)
+{
+    std::optional<std::size_t> task{};
+
+    // own tasks are taken from the back, stolen ones from the front, so the
+    // owner and the thief don't fight over the same end of the queue
+    {
+        auto& own{*m_queues[worker]};
+        std::lock_guard lock{own.mutex};
+        if (!own.tasks.empty())
+        {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+        }
+    }
+    for (std::size_t i{1}; !task && i < m_queues.size(); i++)
+    {
+        auto& other{*m_queues[(worker + i) % m_queues.size()]};
+        std::lock_guard lock{other.mutex};
+        if (!other.tasks.empty())
+        {
+            task = other.tasks.front();
+            other.tasks.pop_front();
+        }
+    }
+
+    if (!task) { return false; }
+
+    (*m_job)(*task, worker);
+
+    if (--m_remaining == 0)
+    {
+        std::lock_guard lock{m_mutex};
+        m_done.notify_all();
+    }
+    return true;
+}
@@ -5,29 +5,29 @@ using Eigen::Vector2d;
 std::string Ball::getTagsAsString() const
 {
     std::string r{};
-    int i{};
-    for (const auto& tag : tags)
+    m_tags.forEach([&r](TagID tag)
     {
-        if (i == 0) { r.append(tag); }
-        else        { r.append(";" + tag); }
-        i++;
-    }
+        if (!r.empty()) { r.append(";"); }
+        r.append(TagInterner::getName(tag));
+    });
     return r;
 }
-std::deque<std::string> Ball::getTagsFromString(std::string_view str)
+TagSet Ball::getTagsFromString(std::string_view str)
 {
-    return splitString(static_cast<std::string>(str), ';');
+    TagSet r{};
+    for (const auto& tag : splitString(static_cast<std::string>(str), ';'))
+    {
+        if (!tag.empty()) { r.insert(TagInterner::intern(tag)); }
+    }
+    return r;
 }
 
 bool Ball::hasTag(std::string_view tag) const
 {
     if (tag.empty()) { return true; }
 
-    for (auto& t : tags)
-    {
-        if (t == tag) { return true; }
-    }
-    return false;
+    const auto id{TagInterner::find(tag)};
+    return id && m_tags.contains(*id);
 }
 
 bool Ball::isInBounds(Rect bounds, Time time) const
@@ -42,9 +42,11 @@ bool Ball::isInBounds(Rect bounds, Time time) const
     return false;
 }
 
-double Ball::getKineticEnergy(Time time) const
+double Ball::getKineticEnergy(Time time
+    , std::optional<KeyframeCursor> cursor) const
 {
-    double speedSquared{getLastKeyframeBeforeTime(time).velocity.squaredNorm()};
+    double speedSquared
+        {getLastKeyframeBeforeTime(time, cursor).velocity.squaredNorm()};
 
     return (m_mass * speedSquared) / 2;
 }
@@ -60,6 +62,16 @@ void Ball::purgeKeyframes(Keyframe replacement)
     // errors
     newKeyframe(replacement);
     m_keyframes.erase(m_keyframes.begin(), m_keyframes.end() - 1);
+    m_cursors.fill(0);
+}
+
+void Ball::evictKeyframes(std::size_t count)
+{
+    count = std::min(count, m_keyframes.size() - 1);
+    m_keyframes.erase(m_keyframes.begin()
+        , m_keyframes.begin() + static_cast<std::ptrdiff_t>(count));
+
+    for (auto& c : m_cursors) { c -= std::min(c, count); }
 }
 
 bool operator== (const Ball& a, const Ball& b)
@@ -71,14 +83,34 @@ bool operator!= (const Ball& a, const Ball& b)
     return !operator==(a, b);
 }
 
-const Vector2d Ball::getPositionAtTime(Time time) const
+const Vector2d Ball::getPositionAtTime(Time time
+    , std::optional<KeyframeCursor> cursor) const
 {
-    auto& k{getLastKeyframeBeforeTime(time)};
+    auto& k{getLastKeyframeBeforeTime(time, cursor)};
 
     return k.startPosition + k.velocity * (time - k.keyframeTime).getS();
 }
 
-const Keyframe& Ball::getLastKeyframeBeforeTime(Time time) const
+const Keyframe& Ball::getLastKeyframe() const
+{
+    if (m_keyframes.empty())
+    {
+        Debug::err("keyframe list for ball with id " + std::to_string(m_id)
+            + " is empty. something is horribly wrong.");
+        throw WorldException::KeyframeListEmpty;
+    }
+    return m_keyframes.back();
+}
+
+std::optional<Time> Ball::getNextKeyframeTime(const Keyframe& keyframe) const
+{
+    const auto next{static_cast<std::size_t>(&keyframe - m_keyframes.data()) + 1};
+    if (next >= m_keyframes.size()) { return std::nullopt; }
+    return m_keyframes[next].keyframeTime;
+}
+
+const Keyframe& Ball::getLastKeyframeBeforeTime(Time time
+    , std::optional<KeyframeCursor> cursor) const
 {
     if (m_keyframes.empty())
     {
@@ -86,31 +118,66 @@ const Keyframe& Ball::getLastKeyframeBeforeTime(Time time) const
             + " is empty. something is horribly wrong.");
         throw WorldException::KeyframeListEmpty;
     }
+    if (time < m_keyframes.front().keyframeTime)
+    {
+        throw WorldException::TimeInaccessible;
+    }
+
+    if (!cursor)
+    {
+        return m_keyframes[findKeyframe(time, 0, m_keyframes.size())];
+    }
 
-    // starting from last keyframe, searches for first keyframe with time before
-    // the specified time
-    for (auto& k : std::views::reverse(m_keyframes))
+    // keyframes could have been purged since the cursor was last used
+    auto& c{m_cursors[static_cast<std::size_t>(*cursor)]};
+    c = std::min(c, m_keyframes.size() - 1);
+
+    // galloping search: the keyframe is bracketed with steps that double
+    // every time, then found by binary search inside the bracket. small moves
+    // in time cost O(1), big jumps are never worse than O(log n)
+    std::size_t first{c};
+    std::size_t end{c + 1};
+    std::size_t step{1};
+    if (time < m_keyframes[c].keyframeTime)
     {
-        if (k.keyframeTime <= time)
+        end = c;
+        first = c - std::min(c, step);
+        while (first > 0 && time < m_keyframes[first].keyframeTime)
         {
-            return k;
+            end = first;
+            step *= 2;
+            first -= std::min(first, step);
         }
     }
-    // Debug::err("time is inaccessible: " + std::to_string(time.getS()));
-    // return m_keyframes[0];
+    else
+    {
+        while (end < m_keyframes.size() && m_keyframes[end].keyframeTime <= time)
+        {
+            first = end;
+            step *= 2;
+            end = std::min(m_keyframes.size(), first + step);
+        }
+    }
+    c = findKeyframe(time, first, end);
 
-    throw WorldException::TimeInaccessible;
+    return m_keyframes[c];
 }
 
-Ball& World::newBall(double radius, Vector2d position, double mass
-    , Vector2d velocity, SDL_Color color, Time time)
+std::size_t Ball::findKeyframe(Time time, std::size_t first, std::size_t end) const
 {
-    Ball ball{radius, position, mass, velocity, color, time};
+    // first keyframe after time, the one before it is the one we want
+    const auto it{std::upper_bound(m_keyframes.begin() 
+        + static_cast<std::ptrdiff_t>(first)
+        , m_keyframes.begin() + static_cast<std::ptrdiff_t>(end), time
+        , [](Time t, const Keyframe& k) { return t < k.keyframeTime; })};
 
-    if (m_bounds && !ball.isInBounds(m_bounds.value(), time))
-    {
-        throw WorldException::InvalidBallPosition;
-    }
+    return static_cast<std::size_t>(it - m_keyframes.begin()) - 1;
+}
+
+Ball& World::newBall(double radius, Vector2d position, double mass
+    , Vector2d velocity, SDL_Color color, Time time
+    , const TagSet& tags)
+{
     // a good programmer would unify this check with the one in physics.cpp.
     // i am not a good programmer.
     for (auto& b : m_balls)
@@ -126,10 +193,298 @@ Ball& World::newBall(double radius, Vector2d position, double mass
             throw WorldException::InvalidBallPosition;
         }
     }
+    return newBallUnchecked(radius, position, mass, velocity, color, time
+        , tags);
+}
+
+Ball& World::newBallUnchecked(double radius, Vector2d position, double mass
+    , Vector2d velocity, SDL_Color color, Time time
+    , const TagSet& tags)
+{
+    Ball ball{radius, position, mass, velocity, color, time, tags};
+
+    if (m_bounds && !ball.isInBounds(m_bounds.value(), time))
+    {
+        throw WorldException::InvalidBallPosition;
+    }
+
     m_balls.push_back(ball);
+    m_hot.push(m_balls.back());
+    assignSlot();
+    indexLastBall();
+    addKineticEnergy(m_balls.back(), mass * velocity.squaredNorm() / 2);
     return m_balls.back();
 }
 
+std::vector<BallRejection> World::newBalls(const std::vector<BallSpec>& balls
+    , Time time)
+{
+    std::vector<BallRejection> rejected{};
+    if (balls.empty()) { return rejected; }
+
+    // cells are as wide as the biggest ball, so overlapping balls are always
+    // in the same or neighbouring cells
+    double maxRadius{0};
+    for (const auto& b : m_balls) { maxRadius = std::max(maxRadius, b.getRadius()); }
+    for (const auto& b : balls)   { maxRadius = std::max(maxRadius, b.radius); }
+    const double cellSize{std::max(2 * maxRadius, 1e-9)};
+
+    const auto getCell{[cellSize](const Vector2d& position)
+    {
+        return std::pair<std::int64_t, std::int64_t>{
+            static_cast<std::int64_t>(std::floor(position.x() / cellSize))
+            , static_cast<std::int64_t>(std::floor(position.y() / cellSize))};
+    }};
+    const auto getKey{[](std::int64_t x, std::int64_t y)
+    {
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32
+            | static_cast<std::uint32_t>(y);
+    }};
+
+    std::unordered_map<std::uint64_t, std::vector<std::size_t>> cells{};
+    std::vector<Vector2d> positions{};
+    positions.reserve(m_balls.size() + balls.size());
+    const auto insert{[&](std::size_t ball, const Vector2d& position)
+    {
+        const auto [x, y]{getCell(position)};
+        cells[getKey(x, y)].push_back(ball);
+        positions.push_back(position);
+    }};
+
+    for (std::size_t i{0}; i < m_balls.size(); i++)
+    {
+        insert(i, m_balls[i].getPositionAtTime(time));
+    }
+
+    reserveBalls(m_balls.size() + balls.size());
+    for (std::size_t n{0}; n < balls.size(); n++)
+    {
+        const auto& b{balls[n]};
+        const auto [x, y]{getCell(b.position)};
+
+        std::optional<int> overlaps{};
+        for (std::int64_t dy{-1}; dy <= 1 && !overlaps; dy++)
+        {
+            for (std::int64_t dx{-1}; dx <= 1 && !overlaps; dx++)
+            {
+                const auto cell{cells.find(getKey(x + dx, y + dy))};
+                if (cell == cells.end()) { continue; }
+
+                for (const auto i : cell->second)
+                {
+                    const double distance{m_balls[i].getRadius() + b.radius};
+                    if ((positions[i] - b.position).squaredNorm() 
+                        <= distance * distance)
+                    {
+                        overlaps = m_balls[i].getID();
+                        break;
+                    }
+                }
+            }
+        }
+        if (overlaps)
+        {
+            rejected.push_back({n, overlaps});
+            continue;
+        }
+
+        try
+        {
+            newBallUnchecked(b.radius, b.position, b.mass, b.velocity, b.color
+                , time, b.tags);
+        }
+        catch (WorldException ex)
+        {
+            rejected.push_back({n, std::nullopt});
+            continue;
+        }
+        insert(m_balls.size() - 1, b.position);
+    }
+
+    return rejected;
+}
+
+void World::reserveBalls(std::size_t count)
+{
+    m_balls.reserve(count);
+    m_ballSlots.reserve(count);
+    m_hot.reserve(count);
+}
+
+void World::newKeyframe(std::size_t ball, const Keyframe& keyframe)
+{
+    if (!m_tagEnergy.empty())
+    {
+        const double oldSpeedSquared{m_hot.getVelocity(ball).squaredNorm()};
+        addKineticEnergy(m_balls[ball], m_hot.mass[ball] 
+            * (keyframe.velocity.squaredNorm() - oldSpeedSquared) / 2);
+    }
+
+    m_balls[ball].newKeyframe(keyframe);
+    m_hot.setSegment(ball, keyframe);
+    m_hot.revision[ball]++;
+}
+
+void World::purgeKeyframes(Time purgeTime)
+{
+    for (auto& b : m_balls)
+    {
+        Keyframe replacement{b.getPositionAtTime(purgeTime)
+            , b.getLastKeyframeBeforeTime(purgeTime).velocity, {}};
+        b.purgeKeyframes(replacement);
+    }
+    syncHotState();
+}
+
+void World::syncHotState()
+{
+    // revisions keep counting up, so that nothing predicted for the old
+    // state can be mistaken for being up to date
+    std::vector<std::size_t> oldRevisions{std::move(m_hot.revision)};
+
+    m_hot.clear();
+    for (const auto& b : m_balls) { m_hot.push(b); }
+
+    for (std::size_t i{0}; i < m_hot.size() && i < oldRevisions.size(); i++)
+    {
+        m_hot.revision[i] = oldRevisions[i] + 1;
+    }
+
+    // balls may have been removed, which moves the ones after them
+    rebuildTagIndex();
+    recomputeKineticEnergy();
+}
+
+void World::indexLastBall()
+{
+    const std::size_t i{m_balls.size() - 1};
+    m_balls[i].getTags().forEach([this, i](TagID tag)
+    {
+        if (m_tagIndex.size() <= tag) { m_tagIndex.resize(tag + 1); }
+        m_tagIndex[tag].push_back(i);
+    });
+}
+
+void World::rebuildTagIndex()
+{
+    for (auto& balls : m_tagIndex) { balls.clear(); }
+
+    for (std::size_t i{0}; i < m_balls.size(); i++)
+    {
+        m_balls[i].getTags().forEach([this, i](TagID tag)
+        {
+            if (m_tagIndex.size() <= tag) { m_tagIndex.resize(tag + 1); }
+            m_tagIndex[tag].push_back(i);
+        });
+    }
+}
+
+void World::enforceKeyframeRetention(Time now, Time oldestNeeded)
+{
+    if (!m_retention.isLimited()) { return; }
+
+    // keyframes only needed for times before this can go
+    std::optional<Time> cutoff{};
+    if (m_retention.maxAge) { cutoff = now - *m_retention.maxAge; }
+
+    bool overBudget{false};
+    if (m_retention.memoryBudget)
+    {
+        const std::size_t maxKeyframes
+            {*m_retention.memoryBudget / sizeof(Keyframe)};
+
+        if (getKeyframeCount() > maxKeyframes)
+        {
+            overBudget = true;
+            // going well under the budget means this doesn't have to be
+            // done again right away
+            const Time budgetCutoff
+                {findBudgetCutoff(maxKeyframes / 4 * 3, oldestNeeded)};
+            cutoff = cutoff ? std::max(*cutoff, budgetCutoff) : budgetCutoff;
+        }
+    }
+
+    for (auto& b : m_balls)
+    {
+        const std::size_t size{b.m_keyframes.size()};
+        // the keyframe the window is showing and everything after it stays
+        const std::size_t evictable{size - keptAfter(b, oldestNeeded)};
+
+        std::size_t evict{cutoff ? size - keptAfter(b, *cutoff) : 0};
+        const bool overCount{m_retention.maxKeyframes
+            && size > *m_retention.maxKeyframes};
+        if (overCount)
+        {
+            evict = std::max(evict, size - *m_retention.maxKeyframes);
+        }
+        evict = std::min(evict, evictable);
+
+        // erasing moves the whole history of the ball, so for the age limit
+        // it's only done once a good part of it can go. the budget and the
+        // keyframe count are hard limits though
+        if (evict == 0 || (!overBudget && !overCount && evict * 4 < size))
+        {
+            continue;
+        }
+
+        b.evictKeyframes(evict);
+    }
+}
+
+Time World::findBudgetCutoff(std::size_t maxKeyframes, Time oldestNeeded) const
+{
+    auto keptCount{[this](Time time)
+    {
+        std::size_t r{0};
+        for (const auto& b : m_balls) { r += keptAfter(b, time); }
+        return r;
+    }};
+
+    if (keptCount(oldestNeeded) > maxKeyframes) { return oldestNeeded; }
+
+    // fewer keyframes are kept the later the cutoff is, so the earliest
+    // cutoff that fits can be found by bisection
+    int64_t first{oldestNeeded.getNS()};
+    for (const auto& b : m_balls)
+    {
+        first = std::min(first, b.m_keyframes.front().keyframeTime.getNS());
+    }
+    int64_t last{oldestNeeded.getNS()};
+
+    while (first < last)
+    {
+        const int64_t middle{first + (last - first) / 2};
+        if (keptCount(Time::makeNS(middle)) <= maxKeyframes) { last = middle; }
+        else { first = middle + 1; }
+    }
+    return Time::makeNS(last);
+}
+
+std::size_t World::keptAfter(const Ball& ball, Time time)
+{
+    const auto& keyframes{ball.m_keyframes};
+    if (time < keyframes.front().keyframeTime) { return keyframes.size(); }
+
+    return keyframes.size() - ball.findKeyframe(time, 0, keyframes.size());
+}
+
+Time World::getHistoryStart() const
+{
+    Time r{};
+    for (const auto& b : m_balls)
+    {
+        r = std::max(r, b.m_keyframes.front().keyframeTime);
+    }
+    return r;
+}
+
+std::size_t World::getKeyframeCount() const
+{
+    std::size_t r{0};
+    for (const auto& b : m_balls) { r += b.m_keyframes.size(); }
+    return r;
+}
+
 void World::setWorldBounds(const Rect& bounds, Time time)
 {
     for (const auto& b : m_balls)
@@ -152,29 +507,278 @@ void World::setWorldBounds(const std::optional<Rect>& bounds, Time time)
     setWorldBounds(bounds.value(), time);
 }
 
+BallHandle World::getHandle(std::size_t index) const
+{
+    const std::uint32_t slot{m_ballSlots.at(index)};
+    return {slot, m_slots[slot].generation};
+}
+
+std::optional<std::size_t> World::getIndex(BallHandle handle) const
+{
+    if (handle.slot >= m_slots.size()) { return std::nullopt; }
+
+    const auto& slot{m_slots[handle.slot]};
+    if (slot.generation != handle.generation) { return std::nullopt; }
+    return slot.ball;
+}
+
+std::optional<BallHandle> World::findBall(int ID) const
+{
+    const auto it{m_idSlots.find(ID)};
+    if (it == m_idSlots.end()) { return std::nullopt; }
+    return BallHandle{it->second, m_slots[it->second].generation};
+}
+
 Ball& World::getBallByID(int ID)
 {
-    auto& ballList{getBallsModifiable()};
-    int i{0};
-    for (auto& b : ballList)
+    const auto handle{findBall(ID)};
+    if (!handle) { throw WorldException::BallNotFound; }
+    return m_balls[*getIndex(*handle)];
+}
+
+void World::deleteBall(int ID)
+{
+    if (!deleteBalls({ID}).empty()) { throw WorldException::BallNotFound; }
+}
+
+std::vector<int> World::deleteBalls(const std::vector<int>& IDs)
+{
+    std::vector<int> missing{};
+    for (const int ID : IDs)
+    {
+        const auto handle{findBall(ID)};
+        if (!handle)
+        {
+            missing.push_back(ID);
+            continue;
+        }
+        removeBall(*getIndex(*handle));
+    }
+    return missing;
+}
+
+void World::assignSlot()
+{
+    std::uint32_t slot{};
+    if (!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<std::uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+    }
+
+    const std::size_t index{m_balls.size() - 1};
+    m_slots[slot].ball = index;
+    m_ballSlots.push_back(slot);
+    m_idSlots[m_balls[index].getID()] = slot;
+}
+
+void World::removeBall(std::size_t index)
+{
+    const std::uint32_t slot{m_ballSlots[index]};
+    m_idSlots.erase(m_balls[index].getID());
+    m_slots[slot].ball.reset();
+    m_slots[slot].generation++;
+    m_freeSlots.push_back(slot);
+
+    // not counted as an update, a recompute now would still see the ball
+    shiftKineticEnergy(m_balls[index], -m_hot.mass[index]
+        * m_hot.getVelocity(index).squaredNorm() / 2);
+
+    m_balls[index].getTags().forEach([this, index](TagID tag)
+    {
+        auto& balls{m_tagIndex[tag]};
+        balls.erase(std::lower_bound(balls.begin(), balls.end(), index));
+    });
+
+    const std::size_t last{m_balls.size() - 1};
+    if (index != last)
+    {
+        // the last ball has the highest index, so it's at the back of the
+        // list of every tag it has
+        m_balls[last].getTags().forEach([this, index](TagID tag)
+        {
+            auto& balls{m_tagIndex[tag]};
+            balls.pop_back();
+            balls.insert(std::lower_bound(balls.begin(), balls.end(), index)
+                , index);
+        });
+
+        m_balls[index] = std::move(m_balls[last]);
+        m_ballSlots[index] = m_ballSlots[last];
+        m_slots[m_ballSlots[index]].ball = index;
+    }
+    m_balls.pop_back();
+    m_ballSlots.pop_back();
+    m_hot.swapRemove(index);
+}
+
+void World::clearBalls()
+{
+    for (const auto slot : m_ballSlots)
+    {
+        m_slots[slot].ball.reset();
+        m_slots[slot].generation++;
+        m_freeSlots.push_back(slot);
+    }
+    m_ballSlots.clear();
+    m_idSlots.clear();
+
+    m_balls.clear();
+    m_hot.clear();
+    m_tagIndex.clear();
+    recomputeKineticEnergy();
+}
+
+double World::getCurrentKineticEnergy(std::string_view tag)
+{
+    // interning a tag no ball has yet is harmless, and means the sum stays
+    // right once balls with it are added
+    const std::optional<TagID> id{tag.empty() ? std::nullopt
+        : std::optional<TagID>{TagInterner::intern(tag)}};
+
+    for (const auto& e : m_tagEnergy)
+    {
+        if (e.tag == id) { return e.sum; }
+    }
+
+    m_tagEnergy.push_back({id, 0});
+    recomputeKineticEnergy();
+    return m_tagEnergy.back().sum;
+}
+
+void World::recomputeKineticEnergy()
+{
+    m_energyUpdates = 0;
+    for (auto& e : m_tagEnergy)
     {
-        if (b.getID() == ID)
+        e.sum = 0;
+        const auto add{[this, &e](std::size_t i)
+        {
+            e.sum += m_hot.mass[i] * m_hot.getVelocity(i).squaredNorm() / 2;
+        }};
+
+        if (!e.tag)
         {
-            return b;
+            for (std::size_t i{0}; i < m_balls.size(); i++) { add(i); }
+        }
+        else if (*e.tag < m_tagIndex.size())
+        {
+            for (const auto i : m_tagIndex[*e.tag]) { add(i); }
         }
-        i++;
     }
-    throw WorldException::BallNotFound;
+}
+
+void World::addKineticEnergy(const Ball& ball, double delta)
+{
+    if (m_tagEnergy.empty()) { return; }
+
+    shiftKineticEnergy(ball, delta);
+
+    m_energyUpdates++;
+    if (m_energyUpdates >= std::max(m_energyRecomputeInterval, m_balls.size()))
+    {
+        recomputeKineticEnergy();
+    }
+}
+
+void World::shiftKineticEnergy(const Ball& ball, double delta)
+{
+    for (auto& e : m_tagEnergy)
+    {
+        if (!e.tag || ball.hasTag(*e.tag)) { e.sum += delta; }
+    }
 }
 
 std::vector<std::reference_wrapper<Ball>> World::getBallsWithTag(std::string_view tag)
 {
     std::vector<std::reference_wrapper<Ball>> r{};
+    forEachBallWithTag(tag, [this, &r](std::size_t i) { r.push_back(m_balls[i]); });
+    return r;
+}
 
-    for (auto& b : m_balls)
+void HotState::setSegment(std::size_t i, const Keyframe& keyframe)
+{
+    positionX[i] = keyframe.startPosition.x();
+    positionY[i] = keyframe.startPosition.y();
+    velocityX[i] = keyframe.velocity.x();
+    velocityY[i] = keyframe.velocity.y();
+    segmentStart[i] = keyframe.keyframeTime;
+}
+
+void HotState::push(const Ball& ball)
+{
+    const Keyframe& k{ball.getLastKeyframe()};
+
+    positionX.push_back(k.startPosition.x());
+    positionY.push_back(k.startPosition.y());
+    velocityX.push_back(k.velocity.x());
+    velocityY.push_back(k.velocity.y());
+    segmentStart.push_back(k.keyframeTime);
+
+    radius.push_back(ball.getRadius());
+    mass.push_back(ball.getMass());
+    id.push_back(ball.getID());
+    revision.push_back(0);
+}
+
+void HotState::swapRemove(std::size_t i)
+{
+    const std::size_t last{size() - 1};
+    if (i != last)
     {
-        if (b.hasTag(tag)) { r.push_back(b); }
+        positionX[i] = positionX[last];
+        positionY[i] = positionY[last];
+        velocityX[i] = velocityX[last];
+        velocityY[i] = velocityY[last];
+        segmentStart[i] = segmentStart[last];
+
+        radius[i] = radius[last];
+        mass[i] = mass[last];
+        id[i] = id[last];
+        // past both, so that nothing predicted for either ball at this index
+        // is mistaken for being up to date
+        revision[i] = std::max(revision[i], revision[last]) + 1;
     }
 
-    return r;
+    positionX.pop_back();
+    positionY.pop_back();
+    velocityX.pop_back();
+    velocityY.pop_back();
+    segmentStart.pop_back();
+    radius.pop_back();
+    mass.pop_back();
+    id.pop_back();
+    revision.pop_back();
+}
+
+void HotState::reserve(std::size_t count)
+{
+    positionX.reserve(count);
+    positionY.reserve(count);
+    velocityX.reserve(count);
+    velocityY.reserve(count);
+    segmentStart.reserve(count);
+
+    radius.reserve(count);
+    mass.reserve(count);
+    id.reserve(count);
+    revision.reserve(count);
+}
+
+void HotState::clear()
+{
+    positionX.clear();
+    positionY.clear();
+    velocityX.clear();
+    velocityY.clear();
+    segmentStart.clear();
+    radius.clear();
+    mass.clear();
+    id.clear();
+    revision.clear();
 }
\ No newline at end of file